@@ -15,23 +15,16 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(engine.pri)
+
 SOURCES += \
-    bitfield.cpp \
-    debug.cpp \
     fieldwidget.cpp \
     main.cpp \
-    mainwindow.cpp \
-    mctsnode.cpp \
-    mctstree.cpp
+    mainwindow.cpp
 
 HEADERS += \
-    common.h \
-    bitfield.h \
-    debug.h \
     fieldwidget.h \
-    mainwindow.h \
-    mctsnode.h \
-    mctstree.h
+    mainwindow.h
 
 FORMS += \
     fieldwidget.ui \
@@ -1,17 +1,22 @@
 import json
+import sys
 
-with open('Templates.json') as json_file:
-    data = json.load(json_file)
+# Without arguments prints the MOVE_PATTERNS rows for Templates.json.
+# "TemplatesGenerator.py Templates.json movepatterns.h" writes the header the engine is built with.
+
+
+def generate_rows(data, log):
+    rows = []
     template_id = 0
     patterns_mapping = {}
     for template in data['templates']:
         patterns_mapping[template['uniqueId']] = template['pattern']
     miai_points = {}
     for points in data['miai_points']:
-        print("-")
-        print("Miai id: ", points['miaiId'])
+        log("-")
+        log("Miai id: ", points['miaiId'])
         for pattern_id in points['patterns']:
-            print(patterns_mapping[pattern_id], "      ", pattern_id)
+            log(patterns_mapping[pattern_id], "      ", pattern_id)
             miai_points[pattern_id] = points['miaiId']
     for template in data['templates']:
         pattern = template["pattern"]
@@ -111,5 +116,33 @@ with open('Templates.json') as json_file:
             shift += 1
         defence_out = f"{{{str(defence_index).strip('[]')}}}"
         defence_priority_out = f"{{{str(defence_priority).strip('[]')}}}"
-        print(f"{{{template_id}, {int(attack_pattern, 2)}, {int(empty_pattern, 2)}, {int(enemy_pattern, 2)}, {attack_shift}, {empty_shift}, {enemy_shift}, {template['priority']}, {miai_points[template['uniqueId']]}, {defence_out}, {defence_priority_out}}},")
-        template_id += 1
\ No newline at end of file
+        rows.append(f"{{{template_id}, {int(attack_pattern, 2)}, {int(empty_pattern, 2)}, {int(enemy_pattern, 2)}, {attack_shift}, {empty_shift}, {enemy_shift}, {template['priority']}, {miai_points[template['uniqueId']]}, {defence_out}, {defence_priority_out}}},")
+        template_id += 1
+    return rows
+
+
+def miai_ids_count(data):
+    return max(points['miaiId'] for points in data['miai_points']) + 1
+
+
+def write_header(rows, miai_count, path):
+    with open(path, 'w') as header:
+        header.write("// Generated by TemplatesGenerator.py from Templates.json, edit the templates instead.\n")
+        header.write("#pragma once\n\n")
+        header.write("#include \"common.h\"\n\n")
+        header.write(f"static constexpr unsigned PATTERNS_COUNT = {len(rows)};\n")
+        header.write(f"static constexpr unsigned MIAI_IDS_COUNT = {miai_count};\n")
+        header.write("static constexpr std::array<AIPattern, PATTERNS_COUNT> MOVE_PATTERNS = {{\n")
+        for row in rows:
+            header.write(f"    {row}\n")
+        header.write("}};\n")
+
+
+if len(sys.argv) == 3:
+    with open(sys.argv[1]) as json_file:
+        data = json.load(json_file)
+        write_header(generate_rows(data, lambda *args: None), miai_ids_count(data), sys.argv[2])
+else:
+    with open('Templates.json') as json_file:
+        for row in generate_rows(json.load(json_file), print):
+            print(row)
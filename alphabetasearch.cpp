@@ -0,0 +1,334 @@
+#include "alphabetasearch.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+// worth of one cell of an attack bucket by its priority
+constexpr std::array<int, MOVE_PRIORITIES::IMMIDIATE + 1> CELL_VALUES = {0, 1, 4, 10, 40, 100, 400, 1000, 4000};
+}
+
+template<short SIZE>
+unsigned BasicAlphaBetaSearch<SIZE>::NODES_PER_UPDATE = 1000;
+
+template<short SIZE>
+unsigned BasicAlphaBetaSearch<SIZE>::MAX_BRANCHING = 12;
+
+template<short SIZE>
+BasicAlphaBetaSearch<SIZE>::BasicAlphaBetaSearch(short evalColor, size_t transpositionsCount) {
+    size_t entriesCount = 1;
+    while (entriesCount * 2 <= transpositionsCount) {
+        entriesCount *= 2;
+    }
+    _transpositions.resize(entriesCount);
+    _transpositionsMask = entriesCount - 1;
+
+    reset(evalColor);
+}
+
+template<short SIZE>
+void BasicAlphaBetaSearch<SIZE>::reset(short) {
+    std::fill(_transpositions.begin(), _transpositions.end(), Transposition());
+    _isRootSet = false;
+    _rootMoves.clear();
+    _depth = 0;
+    _totalNodes = 0;
+}
+
+template<short SIZE>
+void BasicAlphaBetaSearch<SIZE>::selectChild(short, short) {
+    // the next update() brings the position, the transpositions stay useful after the move
+    _isRootSet = false;
+    _rootMoves.clear();
+    _depth = 0;
+    _totalNodes = 0;
+}
+
+template<short SIZE>
+void BasicAlphaBetaSearch<SIZE>::setRoot(const BitField* const rootState) {
+    _field = *rootState;
+    _journal.clear();
+    _isRootSet = true;
+
+    auto history = rootState->getGameHistory();
+    _rootColor = getNextPlayerColor(history.size() > 0 ? history.back()[2] : 0);
+
+    _rootMoves.clear();
+    _depth = 0;
+    _moves.clear();
+    if (_field.getGameStatus() == 0) {
+        pushMoves(_rootColor, -1, BitField::LENGTH);
+    }
+    for (short move : _moves) {
+        _rootMoves.push_back({move, 0});
+    }
+    _moves.clear();
+}
+
+template<short SIZE>
+void BasicAlphaBetaSearch<SIZE>::update(const BitField* const rootState) {
+    if (!_isRootSet || _field.getHash() != rootState->getHash()) {
+        setRoot(rootState);
+    }
+
+    bool isDecided = _depth > 0 && (isWinScore(_rootMoves.front().score) || isLossScore(_rootMoves.front().score));
+    if (_rootMoves.empty() || isDecided || _depth >= MAX_DEPTH) {
+        return;
+    }
+
+    _nodesCount = 0;
+    _isAborted = false;
+
+    short depth = _depth + 1;
+    short opponent = getNextPlayerColor(_rootColor);
+    std::vector<RootMove> rootMoves = _rootMoves;
+    int alpha = -WIN_SCORE - 1;
+    const int beta = WIN_SCORE + 1;
+    size_t best = 0;
+    for (size_t i = 0; i < rootMoves.size() && !_isAborted; ++i) {
+        short move = rootMoves[i].move;
+        unsigned nodesBefore = _nodesCount++;
+        if (!_field.makeMove(Geometry::extractX(move), Geometry::extractY(move), _rootColor, &_journal)) {
+            rootMoves[i].score = -WIN_SCORE - 1;
+            continue;
+        }
+
+        int score = 0;
+        if (_field.getGameStatus() == _rootColor) {
+            score = WIN_SCORE;
+        } else if (_field.getGameStatus() != 0) {
+            score = 0;
+        } else if (i == 0) {
+            score = -search(depth - 1, 1, -beta, -alpha, opponent);
+        } else {
+            score = -search(depth - 1, 1, -alpha - 1, -alpha, opponent);
+            if (score > alpha && !_isAborted) {
+                score = -search(depth - 1, 1, -beta, -alpha, opponent);
+            }
+        }
+        _field.unmakeMove(_journal);
+
+        rootMoves[i].nodes += _nodesCount - nodesBefore;
+        rootMoves[i].score = score;
+        if (score > alpha) {
+            alpha = score;
+            best = i;
+        }
+    }
+    _totalNodes += _nodesCount;
+
+    if (_isAborted) {
+        // the next update() searches this depth again, the nodes spent on it still count
+        for (size_t i = 0; i < rootMoves.size(); ++i) {
+            _rootMoves[i].nodes = rootMoves[i].nodes;
+        }
+        return;
+    }
+
+    // the best move first, a tie with one of the bounds after it keeps it there
+    std::rotate(rootMoves.begin(), rootMoves.begin() + best, rootMoves.begin() + best + 1);
+    std::stable_sort(rootMoves.begin() + 1, rootMoves.end(), [](const RootMove& a, const RootMove& b) {
+        return a.score > b.score;
+    });
+    _rootMoves = std::move(rootMoves);
+    _depth = depth;
+}
+
+template<short SIZE>
+int BasicAlphaBetaSearch<SIZE>::search(short depth, short ply, int alpha, int beta, short color) {
+    // the side to move finishes a five
+    if (!_field.getAttackPriorities(color).isEmpty(MOVE_PRIORITIES::IMMIDIATE)) {
+        return WIN_SCORE - ply;
+    }
+
+    if (depth <= 0 || ply >= MAX_DEPTH * 2) {
+        return evaluate(color);
+    }
+
+    if (isOutOfBudget()) {
+        return 0;
+    }
+
+    uint64_t hash = _field.getHash();
+    Transposition& entry = _transpositions[hash & _transpositionsMask];
+    short firstMove = -1;
+    if (entry.key == hash) {
+        firstMove = entry.move;
+        if (entry.depth >= depth) {
+            // wins are stored relative to the position
+            int score = isWinScore(entry.score) ? entry.score - ply : isLossScore(entry.score) ? entry.score + ply : entry.score;
+            if (entry.bound == Bound::EXACT || (entry.bound == Bound::LOWER && score >= beta) || (entry.bound == Bound::UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    size_t first = _moves.size();
+    pushMoves(color, firstMove, MAX_BRANCHING);
+    if (_moves.size() == first) {
+        return 0;
+    }
+
+    // the moves left out lose to a five, unless they were pruned
+    bool isComplete = _moves.size() - first >= _field.getAvailableMoves().size() || !_field.getDefencePriorities(color).isEmpty(MOVE_PRIORITIES::IMMIDIATE);
+
+    // a forced reply doesn't use up depth
+    if (_moves.size() == first + 1) {
+        depth++;
+    }
+
+    short opponent = getNextPlayerColor(color);
+    int originalAlpha = alpha;
+    int bestScore = -WIN_SCORE - 1;
+    short bestMove = -1;
+    for (size_t i = first; i < _moves.size(); ++i) {
+        short move = _moves[i];
+        _nodesCount++;
+        if (!_field.makeMove(Geometry::extractX(move), Geometry::extractY(move), color, &_journal)) {
+            continue;
+        }
+
+        int score = 0;
+        if (_field.getGameStatus() == color) {
+            score = WIN_SCORE - ply;
+        } else if (_field.getGameStatus() != 0) {
+            score = 0;
+        } else if (i == first) {
+            score = -search(depth - 1, ply + 1, -beta, -alpha, opponent);
+        } else {
+            score = -search(depth - 1, ply + 1, -alpha - 1, -alpha, opponent);
+            if (score > alpha && score < beta && !_isAborted) {
+                score = -search(depth - 1, ply + 1, -beta, -alpha, opponent);
+            }
+        }
+        _field.unmakeMove(_journal);
+
+        if (_isAborted) {
+            break;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) {
+            break;
+        }
+    }
+    _moves.resize(first);
+
+    if (_isAborted || bestMove < 0) {
+        return _isAborted ? 0 : bestScore;
+    }
+
+    if (!isComplete && isLossScore(bestScore)) {
+        bestScore = -LIKELY_WIN_SCORE;
+    }
+
+    entry.key = hash;
+    entry.score = isWinScore(bestScore) ? bestScore + ply : isLossScore(bestScore) ? bestScore - ply : bestScore;
+    entry.move = bestMove;
+    entry.depth = depth;
+    entry.bound = bestScore <= originalAlpha ? Bound::UPPER : bestScore >= beta ? Bound::LOWER : Bound::EXACT;
+
+    return bestScore;
+}
+
+template<short SIZE>
+int BasicAlphaBetaSearch<SIZE>::evaluate(short color) const {
+    const PriorityBuckets<BitField::LENGTH>& attacks = _field.getAttackPriorities(color);
+    const PriorityBuckets<BitField::LENGTH>& threats = _field.getAttackPriorities(getNextPlayerColor(color));
+
+    // the threats of the side to move are a tempo ahead
+    int score = 0;
+    for (short priority = 1; priority <= MOVE_PRIORITIES::IMMIDIATE; ++priority) {
+        score += CELL_VALUES[priority] * (static_cast<int>(attacks.getBucket(priority).size()) * 3 / 2 - static_cast<int>(threats.getBucket(priority).size()));
+    }
+
+    return score;
+}
+
+template<short SIZE>
+bool BasicAlphaBetaSearch<SIZE>::isOutOfBudget() {
+    if (NODES_PER_UPDATE > 0 && _nodesCount >= NODES_PER_UPDATE) {
+        _isAborted = true;
+    }
+
+    return _isAborted;
+}
+
+template<short SIZE>
+void BasicAlphaBetaSearch<SIZE>::pushMoves(short color, short firstMove, size_t limit) {
+    size_t first = _moves.size();
+    if (firstMove >= 0) {
+        _moves.push_back(firstMove);
+    }
+
+    typename BitField::MovesBuffer buffer;
+    auto moves = _field.getBestMoves(color, buffer);
+    if (moves.size() < _field.getAvailableMoves().size()) {
+        // the forced replies getBestMoves narrowed the position to, all of them
+        size_t forcedFirst = _moves.size();
+        pushBucket(moves, first, BitField::LENGTH);
+        std::stable_sort(_moves.begin() + forcedFirst, _moves.end(), [this, color](short a, short b) {
+            return std::max(_field.getMovePriority(a, color), _field.getMoveDefencePriority(a, color)) >
+                   std::max(_field.getMovePriority(b, color), _field.getMoveDefencePriority(b, color));
+        });
+        return;
+    }
+
+    // a quiet position: the strongest attacks and blocks first, then any cell next to the stones
+    const PriorityBuckets<BitField::LENGTH>& attacks = _field.getAttackPriorities(color);
+    const PriorityBuckets<BitField::LENGTH>& blocks = _field.getDefencePriorities(color);
+    for (short priority = MOVE_PRIORITIES::IMMIDIATE; priority > 0; --priority) {
+        pushBucket(attacks.getBucket(priority), first, limit);
+        pushBucket(blocks.getBucket(priority), first, limit);
+    }
+    pushBucket(moves, first, limit);
+}
+
+template<short SIZE>
+void BasicAlphaBetaSearch<SIZE>::pushBucket(Span<short> moves, size_t first, size_t limit) {
+    for (short move : moves) {
+        if (_moves.size() - first >= limit) {
+            return;
+        }
+        if (std::find(_moves.begin() + first, _moves.end(), move) == _moves.end()) {
+            _moves.push_back(move);
+        }
+    }
+}
+
+template<short SIZE>
+std::vector<AIMoveData> BasicAlphaBetaSearch<SIZE>::getNodesData() const {
+    std::vector<AIMoveData> result;
+    for (size_t i = 0; i < _rootMoves.size(); ++i) {
+        const RootMove& rootMove = _rootMoves[i];
+
+        AIMoveData moveData;
+        moveData.position = rootMove.move;
+        moveData.x = Geometry::extractX(rootMove.move);
+        moveData.y = Geometry::extractY(rootMove.move);
+        moveData.color = _rootColor;
+        moveData.scores = std::clamp(static_cast<float>(rootMove.score) / CELL_VALUES[MOVE_PRIORITIES::IMMIDIATE], -1.f, 1.f);
+        moveData.selectionScore = moveData.scores;
+        moveData.nodeVisits = rootMove.nodes;
+        moveData.moveIndex = static_cast<unsigned>(i);
+        // the bounds of the other moves can prove a loss but not a win
+        moveData.proof = _depth > 0 && i == 0 && isWinScore(rootMove.score) ? 1 : _depth > 0 && isLossScore(rootMove.score) ? -1 : 0;
+        moveData.isChosen = _depth > 0 && i == 0;
+
+        result.push_back(moveData);
+    }
+
+    return result;
+}
+
+template<short SIZE>
+bool BasicAlphaBetaSearch<SIZE>::isSolved() const {
+    return _depth > 0 && isWinScore(_rootMoves.front().score);
+}
+
+template class BasicAlphaBetaSearch<15>;
+template class BasicAlphaBetaSearch<19>;
+template class BasicAlphaBetaSearch<LARGE_BOARD_SIZE>;
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "bitfield.h"
+#include "common.h"
+#include "searcher.h"
+#include <cstdint>
+#include <vector>
+
+// Iterative deepening principal variation search, an alternative to the tree for sharp positions.
+// Every update() takes the next depth as far as its node budget goes, an unfinished iteration is
+// searched again by the next update() from what the transposition table kept of it. Moves come
+// from getBestMoves and are ordered by their attack and defence priorities, a quiet position only
+// tries its MAX_BRANCHING best ones. Leaves are scored by the cells of the priority buckets of
+// both sides. A position whose pruned moves all lose scores LIKELY_WIN_SCORE for the opponent
+// instead of a win, so win scores stay proofs.
+template<short SIZE>
+class BasicAlphaBetaSearch : public BasicSearcher<SIZE>
+{
+public:
+    using BitField = BasicBitField<SIZE>;
+    using Geometry = typename BitField::Geometry;
+    using UndoJournal = typename BitField::UndoJournal;
+
+    // moves made per update()
+    static unsigned NODES_PER_UPDATE;
+    static unsigned MAX_BRANCHING;
+    static constexpr short MAX_DEPTH = 32;
+    // a win in n plies scores WIN_SCORE - n
+    static constexpr int WIN_SCORE = 1000000;
+    // a win against pruned replies, above any evaluation but not a proof
+    static constexpr int LIKELY_WIN_SCORE = WIN_SCORE / 2;
+
+    // scores are from the point of view of the mover, so evalColor isn't needed.
+    // transpositionsCount is rounded down to a power of two
+    explicit BasicAlphaBetaSearch(short evalColor, size_t transpositionsCount = 1 << 18);
+
+    void reset(short evalColor) override;
+    void selectChild(short x, short y) override;
+    void update(const BitField* const rootState) override;
+
+    // the best move first and chosen, the scores of the others are upper bounds.
+    // nodeVisits are the nodes searched below every move since the root was set
+    std::vector<AIMoveData> getNodesData() const override;
+    unsigned getTotalPlayouts() const override { return _totalNodes; }
+    bool isSolved() const override;
+
+    short getDepth() const { return _depth; }
+private:
+    enum class Bound : unsigned char {
+        EXACT,
+        LOWER,
+        UPPER
+    };
+
+    // replaced on every store
+    struct Transposition {
+        uint64_t key = 0;
+        int score = 0;
+        short move = -1;
+        short depth = 0;
+        Bound bound = Bound::EXACT;
+    };
+
+    struct RootMove {
+        short move;
+        int score;
+        unsigned nodes = 0;
+    };
+
+    void setRoot(const BitField* const rootState);
+    // negamax score of the position for color, the side to move
+    int search(short depth, short ply, int alpha, int beta, short color);
+    int evaluate(short color) const;
+    bool isOutOfBudget();
+
+    // pushes the moves of color best first, at most limit of them in a quiet position
+    void pushMoves(short color, short firstMove, size_t limit);
+    void pushBucket(Span<short> moves, size_t first, size_t limit);
+
+    static bool isWinScore(int score) { return score >= WIN_SCORE - BitField::LENGTH; }
+    static bool isLossScore(int score) { return score <= -WIN_SCORE + BitField::LENGTH; }
+private:
+    BitField _field;
+    UndoJournal _journal;
+    bool _isRootSet = false;
+    short _rootColor = 0;
+
+    std::vector<Transposition> _transpositions;
+    size_t _transpositionsMask = 0;
+
+    // ordered by the last finished iteration, the best one first
+    std::vector<RootMove> _rootMoves;
+    short _depth = 0;
+
+    unsigned _nodesCount = 0;
+    unsigned _totalNodes = 0;
+    bool _isAborted = false;
+
+    // candidates of every ply on the way down
+    std::vector<short> _moves;
+};
+
+// instantiated in alphabetasearch.cpp
+extern template class BasicAlphaBetaSearch<15>;
+extern template class BasicAlphaBetaSearch<19>;
+extern template class BasicAlphaBetaSearch<LARGE_BOARD_SIZE>;
+
+using AlphaBetaSearch = BasicAlphaBetaSearch<BOARD_SIZE>;
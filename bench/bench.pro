@@ -0,0 +1,16 @@
+TEMPLATE = app
+TARGET = gomokubench
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += $$PWD/..
+DEPENDPATH += $$PWD/..
+
+LIBS += -L$$OUT_PWD/../engine -lgomokuengine
+PRE_TARGETDEPS += $$OUT_PWD/../engine/libgomokuengine.a
+
+unix: LIBS += -lpthread
+
+SOURCES += \
+    main.cpp
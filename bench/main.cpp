@@ -0,0 +1,605 @@
+#include "alphabetasearch.h"
+#include "bitfield.h"
+#include "mctstree.h"
+#include "threatsearch.h"
+#include "timemanager.h"
+#include "common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Position = std::vector<std::pair<short, short>>;
+
+struct BenchOptions {
+    unsigned replays = 1000;
+    unsigned playouts = 2000;
+    unsigned explores = 2000;
+    unsigned seed = 1;
+    unsigned selfPlayMoves = 0;
+    unsigned checkGames = 0;
+    int64_t moveTimeMs = 0;
+    unsigned threads = 0;
+    unsigned batch = 1;
+    unsigned threatNodes = MCTSTreeBase::ROOT_THREAT_SEARCH_NODES;
+    short boardSize = BOARD_SIZE;
+    size_t transpositions = 0;
+    bool useHugePages = false;
+    bool useAlphaBeta = false;
+    MCTSTreeBase::SearchMode mode = MCTSTreeBase::SearchMode::LEAF_PARALLEL;
+    std::string corpusPath;
+};
+
+// Reference game that used to be replayed by MainWindow::checkPattern.
+const Position REFERENCE_GAME = {{{ 9 , 9 } ,{ 10 , 8 } ,{ 9 , 8 } ,{ 9 , 7 } ,{ 8 , 6 } ,{ 8 , 7 } ,{ 11 , 7 } ,{ 10 , 7 } ,{ 10 , 9 } ,{ 7 , 7 } ,{ 6 , 7 } ,{ 10 , 6 } ,{ 10 , 5 } ,{ 11 , 5 } ,{ 12 , 4 } ,{ 8 , 8 } ,{ 7 , 9 } ,{ 7 , 8 } ,{ 6 , 8 } ,{ 6 , 9 } ,{ 5 , 10 } ,{ 8 , 9 } ,{ 6 , 6 } ,{ 8 , 10 } ,{ 8 , 11 } ,{ 12 , 6 } ,{ 6 , 5 } ,{ 6 , 4 } ,{ 7 , 6 } ,{ 5 , 6 } ,{ 5 , 8 } ,{ 4 , 9 } ,{ 8 , 5 } ,{ 9 , 4 } ,{ 5 , 9 } ,{ 5 , 11 } ,{ 7 , 5 } ,{ 9 , 5 } ,{ 5 , 5 } ,{ 4 , 5 } ,{ 8 , 4 } ,{ 5 , 7 } ,{ 9 , 6 } ,{ 9 , 3 } ,{ 11 , 6 } ,{ 13 , 7 } ,{ 15 , 6 } ,{ 14 , 5 } ,{ 14 , 4 } ,{ 13 , 3 } ,{ 13 , 4 } ,{ 15 , 4 } ,{ 15 , 7 } ,{ 15 , 8 } ,{ 13 , 9 } ,{ 13 , 10 } ,{ 14 , 10 } ,{ 14 , 9 } ,{ 12 , 10 } ,{ 12 , 11 } ,{ 13 , 11 } ,{ 14 , 12 } ,{ 13 , 13 } ,{ 12 , 13 } ,{ 11 , 14 } ,{ 11 , 13 } ,{ 10 , 12 } ,{ 9 , 12 } ,{ 9 , 13 } ,{ 7 , 13 } ,{ 6 , 13 } ,{ 6 , 14 } ,{ 4 , 13 } ,{ 3 , 12 } ,{ 2 , 11 } ,{ 1 , 9 } ,{ 2 , 7 } ,{ 3 , 10 } ,{ 2 , 8 } ,{ 3 , 8 } ,{ 3 , 6 } ,{ 3 , 5 } ,{ 2 , 5 } ,{ 1 , 6 } ,{ 1 , 2 } ,{ 4 , 3 } ,{ 5 , 2 } ,{ 8 , 2 } ,{ 11 , 1 } ,{ 12 , 1 } ,{ 12 , 2 } ,{ 10 , 2 } ,{ 9 , 1 } ,{ 10 , 1 } ,{ 15 , 1 } ,{ 15 , 2 } ,{ 16 , 4 } ,{ 17 , 5 } ,{ 16 , 7 } ,{ 16 , 9 } ,{ 15 , 10 } ,{ 15 , 11 } ,{ 15 , 12 } ,{ 16 , 13 } ,{ 15 , 14 } ,{ 13 , 14 } ,{ 12 , 15 } ,{ 11 , 16 } ,{ 9 , 17 } ,{ 7 , 17 } ,{ 5 , 17 } ,{ 4 , 16 } ,{ 4 , 15 } ,{ 3 , 15 } ,{ 3 , 16 } ,{ 3 , 17 } ,{ 1 , 15 } ,{ 2 , 15 } ,{ 3 , 14 } ,{ 5 , 15 }}};
+constexpr std::array<unsigned, 6> REFERENCE_PLIES = {0, 10, 20, 40, 60, 90};
+
+bool fitsBoard(const Position& position, short boardSize) {
+    return std::all_of(position.begin(), position.end(), [boardSize](const std::pair<short, short>& move) {
+        return move.first >= 0 && move.second >= 0 && move.first < boardSize && move.second < boardSize;
+    });
+}
+
+// prefixes of the reference game that fit the board
+std::vector<Position> builtinCorpus(short boardSize) {
+    std::vector<Position> corpus;
+    for (auto plies : REFERENCE_PLIES) {
+        corpus.emplace_back(REFERENCE_GAME.begin(), REFERENCE_GAME.begin() + plies);
+    }
+    corpus.push_back(REFERENCE_GAME);
+    corpus.erase(std::remove_if(corpus.begin(), corpus.end(), [boardSize](const Position& position) {
+        return !fitsBoard(position, boardSize);
+    }), corpus.end());
+
+    return corpus;
+}
+
+// One position per line: "x,y x,y ...", black moves first. Empty lines and lines starting with '#' are skipped.
+bool loadCorpus(const std::string& path, short boardSize, std::vector<Position>& corpus) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        Position position;
+        std::istringstream stream(line);
+        std::string move;
+        while (stream >> move) {
+            short x = 0, y = 0;
+            if (std::sscanf(move.c_str(), "%hd,%hd", &x, &y) != 2 || x < 0 || y < 0 || x >= boardSize || y >= boardSize) {
+                return false;
+            }
+            position.emplace_back(x, y);
+        }
+        corpus.push_back(position);
+    }
+
+    return !corpus.empty();
+}
+
+short lastMoveColor(const Position& position) {
+    if (position.empty()) {
+        return 0;
+    }
+
+    return position.size() % 2 == 1 ? BLACK_PIECE_COLOR : WHITE_PIECE_COLOR;
+}
+
+template<short SIZE>
+bool setupPosition(BasicBitField<SIZE>& field, const Position& position) {
+    field.clear();
+    short color = FIRST_MOVE_COLOR;
+    for (const auto& move : position) {
+        if (!field.makeMove(move.first, move.second, color)) {
+            return false;
+        }
+        color = getNextPlayerColor(color);
+    }
+
+    return true;
+}
+
+int64_t elapsedNs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void report(const char* name, unsigned long long ops, int64_t ns, unsigned long long playouts, const char* unit = "playouts") {
+    double nsPerOp = ops > 0 ? static_cast<double>(ns) / ops : 0.0;
+    std::printf("%-10s %12llu ops %14.1f ns/op", name, ops, nsPerOp);
+    if (playouts > 0 && ns > 0) {
+        std::printf(" %14.1f %s/sec", playouts * 1e9 / ns, unit);
+    }
+    std::printf("\n");
+}
+
+template<short SIZE>
+void benchMakeMove(const std::vector<Position>& corpus, const BenchOptions& options) {
+    BasicBitField<SIZE> field;
+    unsigned long long moves = 0;
+    auto start = Clock::now();
+    for (const auto& position : corpus) {
+        for (unsigned i = 0; i < options.replays; ++i) {
+            setupPosition(field, position);
+        }
+        moves += static_cast<unsigned long long>(position.size()) * options.replays;
+    }
+
+    report("makeMove", moves, elapsedNs(start), 0);
+}
+
+template<short SIZE>
+void benchPlayout(const std::vector<Position>& corpus, const BenchOptions& options) {
+    std::srand(options.seed);
+
+    BasicMCTSTree<SIZE> tree(WHITE_PIECE_COLOR);
+    BasicBitField<SIZE> field;
+    unsigned long long playouts = 0;
+    int64_t ns = 0;
+    for (const auto& position : corpus) {
+        if (!setupPosition(field, position) || field.getGameStatus() != 0) {
+            continue;
+        }
+
+        auto start = Clock::now();
+        for (unsigned i = 0; i < options.playouts; i += options.batch) {
+            tree.playout(&field, lastMoveColor(position), std::min(options.batch, options.playouts - i));
+        }
+        ns += elapsedNs(start);
+        playouts += options.playouts;
+    }
+
+    report("playout", playouts, ns, playouts);
+}
+
+template<short SIZE>
+std::unique_ptr<BasicSearcher<SIZE>> createSearcher(short evalColor, const BenchOptions& options) {
+    if (options.useAlphaBeta) {
+        return std::make_unique<BasicAlphaBetaSearch<SIZE>>(evalColor);
+    }
+
+    auto tree = std::make_unique<BasicMCTSTree<SIZE>>(evalColor, options.threads, options.useHugePages);
+    tree->setSearchMode(options.mode);
+    tree->setTranspositionTableSize(options.transpositions);
+    return tree;
+}
+
+// Searches every corpus position with the chosen engine until it is solved or out of updates.
+template<short SIZE>
+void benchExplore(const std::vector<Position>& corpus, const BenchOptions& options) {
+    std::srand(options.seed);
+
+    BasicBitField<SIZE> field;
+    unsigned long long updates = 0;
+    unsigned long long playouts = 0;
+    unsigned solved = 0;
+    int64_t ns = 0;
+    int64_t solutionNs = 0;
+    for (const auto& position : corpus) {
+        if (!setupPosition(field, position) || field.getGameStatus() != 0) {
+            continue;
+        }
+
+        auto searcher = createSearcher<SIZE>(getNextPlayerColor(lastMoveColor(position)), options);
+        for (const auto& move : position) {
+            searcher->selectChild(move.first, move.second);
+        }
+
+        auto start = Clock::now();
+        unsigned i = 0;
+        for (; i < options.explores && !searcher->isSolved(); ++i) {
+            searcher->update(&field);
+        }
+        int64_t positionNs = elapsedNs(start);
+        ns += positionNs;
+        updates += i;
+        playouts += searcher->getTotalPlayouts();
+        if (searcher->isSolved()) {
+            solved++;
+            solutionNs += positionNs;
+        }
+    }
+
+    report("explore", updates, ns, playouts, options.useAlphaBeta ? "nodes" : "playouts");
+    std::printf("explore    %12u solved %14.2f ms to a solution on average\n", solved, solved > 0 ? solutionNs / 1e6 / solved : 0.);
+}
+
+// VCF and VCT of the side to move in every corpus position, with the budget of a search root.
+template<short SIZE>
+void benchThreats(const std::vector<Position>& corpus, const BenchOptions& options) {
+    BasicBitField<SIZE> field;
+    typename BasicBitField<SIZE>::UndoJournal journal;
+    BasicThreatSearch<SIZE> threats;
+    typename BasicThreatSearch<SIZE>::Limits limits;
+    limits.maxNodes = options.threatNodes;
+
+    unsigned long long searches = 0;
+    unsigned long long nodes = 0;
+    unsigned wins = 0;
+    int64_t ns = 0;
+    for (const auto& position : corpus) {
+        if (!setupPosition(field, position) || field.getGameStatus() != 0) {
+            continue;
+        }
+
+        short color = getNextPlayerColor(lastMoveColor(position));
+        for (auto mode : {BasicThreatSearch<SIZE>::Mode::VCF, BasicThreatSearch<SIZE>::Mode::VCT}) {
+            auto start = Clock::now();
+            wins += threats.solve(field, journal, color, mode, limits);
+            ns += elapsedNs(start);
+            nodes += threats.getNodesCount();
+            searches++;
+        }
+    }
+
+    report("threats", searches, ns, 0);
+    std::printf("threats    %12llu nodes %14.1f nodes/sec, %u wins\n", nodes, ns > 0 ? nodes * 1e9 / ns : 0., wins);
+}
+
+// Plays one game of the tree against itself, reusing the tree between moves like the app does.
+template<short SIZE>
+void benchSelfPlay(const BenchOptions& options) {
+    std::srand(options.seed);
+
+    BasicBitField<SIZE> field;
+    field.clear();
+    BasicMCTSTree<SIZE> tree(WHITE_PIECE_COLOR, options.threads, options.useHugePages);
+    tree.setSearchMode(options.mode);
+    tree.setTranspositionTableSize(options.transpositions);
+
+    short color = FIRST_MOVE_COLOR;
+    unsigned long long updates = 0;
+    unsigned long long playouts = 0;
+    size_t peakNodes = 0;
+    unsigned moves = 0;
+    unsigned solvedMoves = 0;
+    int64_t ns = 0;
+    int64_t maxMoveNs = 0;
+
+    TimeManager timeManager;
+    TimeManager::Limits limits;
+    limits.moveTimeMs = options.moveTimeMs;
+    limits.movePlayouts = options.moveTimeMs > 0 ? 0 : options.explores;
+    timeManager.setLimits(limits);
+    while (moves < options.selfPlayMoves && field.getGameStatus() == 0) {
+        auto start = Clock::now();
+        timeManager.startMove(tree.getNodesData());
+        do {
+            tree.update(&field);
+            updates++;
+        } while (!timeManager.shouldStop(tree.getNodesData()));
+        short bestPosition = TimeManager::getBestMove(tree.getNodesData());
+        solvedMoves += tree.isSolved();
+        timeManager.finishMove();
+        int64_t moveNs = elapsedNs(start);
+        ns += moveNs;
+        maxMoveNs = std::max(maxMoveNs, moveNs);
+        playouts += tree.getTotalPlayouts();
+        peakNodes = std::max(peakNodes, tree.getAllocatedNodes());
+
+        if (bestPosition < 0) {
+            bestPosition = field.getAvailableMoves().front();
+        }
+
+        short x = BoardGeometry<SIZE>::extractX(bestPosition);
+        short y = BoardGeometry<SIZE>::extractY(bestPosition);
+        if (!field.makeMove(x, y, color)) {
+            break;
+        }
+        tree.selectChild(x, y);
+        color = getNextPlayerColor(color);
+        moves++;
+    }
+
+    report("selfplay", updates, ns, playouts);
+    std::printf("selfplay   %12u moves, status %d, nodes: %zu peak, %zu at the end, %u solved\n", moves, field.getGameStatus(), peakNodes, tree.getAllocatedNodes(), solvedMoves);
+    std::printf("selfplay   %12.2f ms per move on average, %.2f ms at most\n", moves > 0 ? ns / 1e6 / moves : 0., maxMoveNs / 1e6);
+}
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+// checksums of --check 100 --seed 1 on the 15, 19 and 41 boards. A change that is meant to alter
+// the board, its templates or priorities, updates them in the same commit
+constexpr unsigned CHECK_REFERENCE_GAMES = 100;
+constexpr unsigned CHECK_REFERENCE_SEED = 1;
+constexpr uint64_t CHECK_REFERENCE_15 = 0xa8cd7b35fab1beb1ull;
+constexpr uint64_t CHECK_REFERENCE_19 = 0xbe90c30c7b43242aull;
+constexpr uint64_t CHECK_REFERENCE_41 = 0x373d3b493a750ed0ull;
+
+// Everything a move changes that the board shows: stones, hash, status, available moves and the
+// priorities and buckets of both colors. Available moves and buckets are taken in their order,
+// getRandomMove and getMoveByPriority sample by it.
+template<short SIZE>
+uint64_t stateDigest(const BasicBitField<SIZE>& field) {
+    using BitField = BasicBitField<SIZE>;
+
+    uint64_t digest = FNV_OFFSET;
+    auto mix = [&digest](uint64_t value) { digest = (digest ^ value) * FNV_PRIME; };
+    auto mixMoves = [&mix](Span<short> moves) {
+        for (short move : moves) {
+            mix(move);
+        }
+    };
+
+    mix(field.getHash());
+    mix(field.getGameStatus());
+    for (const auto& move : field.getGameHistory()) {
+        mix(move[0]);
+        mix(move[1]);
+        mix(move[2]);
+    }
+    mixMoves(field.getAvailableMoves());
+
+    for (short color = BLACK_PIECE_COLOR; color <= WHITE_PIECE_COLOR; ++color) {
+        for (short cell = 0; cell < BitField::LENGTH; ++cell) {
+            mix(field.getMovePriority(cell, color));
+            mix(field.getMoveDefencePriority(cell, color));
+        }
+        for (short priority = 0; priority < PriorityBuckets<BitField::LENGTH>::BUCKETS_COUNT; ++priority) {
+            mixMoves(field.getAttackPriorities(color).getBucket(priority));
+            mixMoves(field.getDefencePriorities(color).getBucket(priority));
+        }
+    }
+
+    return digest;
+}
+
+// the incremental hash matches a recompute and every bucket holds exactly the available
+// moves, each in the bucket of its priority. nullptr when it does, else what is wrong
+template<short SIZE>
+const char* findInconsistency(const BasicBitField<SIZE>& field) {
+    using BitField = BasicBitField<SIZE>;
+
+    if (field.getHash() != field.computeHash()) {
+        return "hash";
+    }
+
+    size_t availableCount = field.getAvailableMoves().size();
+    for (short color = BLACK_PIECE_COLOR; color <= WHITE_PIECE_COLOR; ++color) {
+        size_t attackCount = 0;
+        size_t defenceCount = 0;
+        for (short priority = 0; priority < PriorityBuckets<BitField::LENGTH>::BUCKETS_COUNT; ++priority) {
+            for (short move : field.getAttackPriorities(color).getBucket(priority)) {
+                if (field.getMovePriority(move, color) != priority) {
+                    return "attack bucket";
+                }
+            }
+            for (short move : field.getDefencePriorities(color).getBucket(priority)) {
+                if (field.getMoveDefencePriority(move, color) != priority) {
+                    return "defence bucket";
+                }
+            }
+            attackCount += field.getAttackPriorities(color).getBucket(priority).size();
+            defenceCount += field.getDefencePriorities(color).getBucket(priority).size();
+        }
+        if (attackCount != availableCount || defenceCount != availableCount) {
+            return "bucket size";
+        }
+    }
+
+    return nullptr;
+}
+
+// Plays seeded games with the journal and checks the board after every move, after taking
+// moves back and after making them again. The moves are picked from the sorted available
+// moves, so another storage order changes the checksum but not the games.
+template<short SIZE>
+bool checkBoard(unsigned games, unsigned seed, uint64_t reference) {
+    using BitField = BasicBitField<SIZE>;
+
+    BitField field;
+    typename BitField::UndoJournal journal;
+    uint64_t checksum = FNV_OFFSET;
+    unsigned long long moves = 0;
+    for (unsigned game = 0; game < games; ++game) {
+        std::srand(seed + game);
+        field.clear();
+        journal.clear();
+
+        // digests of the positions before every move
+        std::vector<uint64_t> digests;
+        short color = FIRST_MOVE_COLOR;
+        while (field.getGameStatus() == 0 && field.getAvailableMoves().size() > 0) {
+            std::vector<short> available(field.getAvailableMoves().begin(), field.getAvailableMoves().end());
+            std::sort(available.begin(), available.end());
+            short move = available[std::rand() % available.size()];
+            if (std::rand() % 8 == 0) {
+                move = *std::max_element(available.begin(), available.end(), [&field, color](short a, short b) {
+                    return field.getMovePriority(a, color) < field.getMovePriority(b, color);
+                });
+            }
+
+            digests.push_back(stateDigest(field));
+            short x = BitField::Geometry::extractX(move);
+            short y = BitField::Geometry::extractY(move);
+            if (!field.makeMove(x, y, color, &journal)) {
+                std::printf("check      board %d game %u: move %d,%d refused\n", SIZE, game, x, y);
+                return false;
+            }
+
+            const char* error = findInconsistency(field);
+            uint64_t digest = stateDigest(field);
+            if (!error && std::rand() % 4 == 0) {
+                field.unmakeMove(journal);
+                error = stateDigest(field) != digests.back() ? "unmake" : findInconsistency(field);
+                field.makeMove(x, y, color, &journal);
+                if (!error && stateDigest(field) != digest) {
+                    error = "remake";
+                }
+            }
+            if (error) {
+                std::printf("check      board %d game %u move %zu: %s\n", SIZE, game, digests.size(), error);
+                return false;
+            }
+
+            checksum = (checksum ^ digest) * FNV_PRIME;
+            color = getNextPlayerColor(color);
+            moves++;
+        }
+
+        while (!digests.empty()) {
+            field.unmakeMove(journal);
+            if (stateDigest(field) != digests.back()) {
+                std::printf("check      board %d game %u: unwinding to move %zu\n", SIZE, game, digests.size());
+                return false;
+            }
+            digests.pop_back();
+        }
+    }
+
+    std::printf("check      board %d: %u games, %llu moves, checksum %016llx\n", SIZE, games, moves, static_cast<unsigned long long>(checksum));
+    if (games == CHECK_REFERENCE_GAMES && seed == CHECK_REFERENCE_SEED && checksum != reference) {
+        std::printf("check      board %d: the reference checksum is %016llx\n", SIZE, static_cast<unsigned long long>(reference));
+        return false;
+    }
+
+    return true;
+}
+
+template<short SIZE>
+void runBenchmarks(const std::vector<Position>& corpus, const BenchOptions& options) {
+    benchMakeMove<SIZE>(corpus, options);
+    benchPlayout<SIZE>(corpus, options);
+    benchExplore<SIZE>(corpus, options);
+    if (options.threatNodes > 0) {
+        benchThreats<SIZE>(corpus, options);
+    }
+    if (options.selfPlayMoves > 0) {
+        benchSelfPlay<SIZE>(options);
+    }
+}
+
+void printUsage(const char* name) {
+    std::printf("Usage: %s [--corpus FILE] [--replays N] [--playouts N] [--explores N] [--seed N] [--threads N] [--batch N] [--board 15|19|41] [--mode leaf|tree|pipelined] [--tt N] [--threats N] [--huge-pages] [--engine mcts|alphabeta] [--selfplay N] [--movetime MS] [--check N]\n", name);
+    std::printf("  --corpus FILE   positions to benchmark, one per line as \"x,y x,y ...\" (black first)\n");
+    std::printf("  --replays N     makeMove replays of every corpus position (default 1000)\n");
+    std::printf("  --playouts N    playouts from every corpus position (default 2000)\n");
+    std::printf("  --explores N    update calls for every corpus position, fewer once it is solved (default 2000)\n");
+    std::printf("  --seed N        random seed (default 1)\n");
+    std::printf("  --threads N     search threads, 0 uses the hardware concurrency (default 0)\n");
+    std::printf("  --batch N       playouts per call and per thread and leaf of the leaf-parallel search (default 1)\n");
+    std::printf("  --board N       board size, 15, 19 or %d (default %d)\n", LARGE_BOARD_SIZE, BOARD_SIZE);
+    std::printf("  --mode MODE     leaf: parallel playouts per leaf, tree: tree-parallel search,\n"
+                "                  pipelined: queued leaves evaluated by the workers (default leaf)\n");
+    std::printf("  --tt N          share statistics between transpositions in a table of N entries (default 0, off)\n");
+    std::printf("  --threats N     node budget of the VCF and the VCT at every search root, 0 turns threat search off (default %u)\n", MCTSTreeBase::ROOT_THREAT_SEARCH_NODES);
+    std::printf("  --huge-pages    back the search tree with huge pages where available\n");
+    std::printf("  --engine NAME   mcts or alphabeta, the engine the explore benchmark runs (default mcts)\n");
+    std::printf("  --selfplay N    also play a game of up to N moves, a move ends after --explores root visits\n"
+                "                  or once the leader can't be passed\n");
+    std::printf("  --movetime MS   give every selfplay move MS milliseconds instead of --explores visits\n");
+    std::printf("  --check N       only check makeMove and unmakeMove over N seeded games on every board size\n"
+                "                  and print a checksum of the positions, exits with 1 on a mismatch, or with\n"
+                "                  --check %u --seed %u on a checksum other than the reference one\n", CHECK_REFERENCE_GAMES, CHECK_REFERENCE_SEED);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--corpus") == 0 && hasValue) {
+            options.corpusPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replays") == 0 && hasValue) {
+            options.replays = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--playouts") == 0 && hasValue) {
+            options.playouts = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--explores") == 0 && hasValue) {
+            options.explores = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--batch") == 0 && hasValue) {
+            options.batch = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--board") == 0 && hasValue) {
+            options.boardSize = static_cast<short>(std::strtol(argv[++i], nullptr, 10));
+            if (options.boardSize != 15 && options.boardSize != 19 && options.boardSize != LARGE_BOARD_SIZE) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--selfplay") == 0 && hasValue) {
+            options.selfPlayMoves = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--check") == 0 && hasValue) {
+            options.checkGames = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--movetime") == 0 && hasValue) {
+            options.moveTimeMs = std::strtoll(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--tt") == 0 && hasValue) {
+            options.transpositions = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threats") == 0 && hasValue) {
+            options.threatNodes = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--huge-pages") == 0) {
+            options.useHugePages = true;
+        } else if (std::strcmp(argv[i], "--engine") == 0 && hasValue) {
+            ++i;
+            if (std::strcmp(argv[i], "alphabeta") == 0) {
+                options.useAlphaBeta = true;
+            } else if (std::strcmp(argv[i], "mcts") != 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--mode") == 0 && hasValue) {
+            ++i;
+            if (std::strcmp(argv[i], "tree") == 0) {
+                options.mode = MCTSTreeBase::SearchMode::TREE_PARALLEL;
+            } else if (std::strcmp(argv[i], "pipelined") == 0) {
+                options.mode = MCTSTreeBase::SearchMode::PIPELINED;
+            } else if (std::strcmp(argv[i], "leaf") != 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (options.checkGames > 0) {
+        bool isOk = checkBoard<15>(options.checkGames, options.seed, CHECK_REFERENCE_15);
+        isOk = checkBoard<19>(options.checkGames, options.seed, CHECK_REFERENCE_19) && isOk;
+        isOk = checkBoard<LARGE_BOARD_SIZE>(options.checkGames, options.seed, CHECK_REFERENCE_41) && isOk;
+        return isOk ? 0 : 1;
+    }
+
+    MCTSTreeBase::LEAF_PLAYOUTS_PER_THREAD = options.batch;
+    MCTSTreeBase::ROOT_THREAT_SEARCH_NODES = options.threatNodes;
+    if (options.threatNodes == 0) {
+        MCTSTreeBase::LEAF_THREAT_SEARCH_NODES = 0;
+    }
+
+    std::vector<Position> corpus;
+    if (options.corpusPath.empty()) {
+        corpus = builtinCorpus(options.boardSize);
+    } else if (!loadCorpus(options.corpusPath, options.boardSize, corpus)) {
+        std::fprintf(stderr, "Failed to load corpus from %s\n", options.corpusPath.c_str());
+        return 1;
+    }
+
+    std::printf("board: %d, positions: %zu, seed: %u\n", options.boardSize, corpus.size(), options.seed);
+    if (options.boardSize == 15) {
+        runBenchmarks<15>(corpus, options);
+    } else if (options.boardSize == LARGE_BOARD_SIZE) {
+        runBenchmarks<LARGE_BOARD_SIZE>(corpus, options);
+    } else {
+        runBenchmarks<19>(corpus, options);
+    }
+
+    return 0;
+}
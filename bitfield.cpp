@@ -1,20 +1,28 @@
 #include "bitfield.h"
-#include <QDebug>
 #include "debug.h"
+#include "movepatterns.h"
+#include <algorithm>
+#include <cassert>
 #include <math.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
-BitField::BitField()
+template<short SIZE>
+BasicBitField<SIZE>::BasicBitField()
     : _gameStatus(0)
 {
 
 }
 
-unsigned long BitField::getDiagonalRightIndex(short x, short y) {
+template<short SIZE>
+unsigned long BasicBitField<SIZE>::getDiagonalRightIndex(short x, short y) {
     return x + y;
 }
 
-unsigned long BitField::getDiagonalLeftIndex(short x, short y) {
-    return BOARD_SIZE - x + y - 1;
+template<short SIZE>
+unsigned long BasicBitField<SIZE>::getDiagonalLeftIndex(short x, short y) {
+    return SIZE - x + y - 1;
 }
 
 long getPatternRight(long& pattern, long value, long opponentValue, long index) {
@@ -39,118 +47,228 @@ long getPatternLeft(long& pattern, long value, long opponentValue, long index) {
     return shifts;
 }
 
-long getConsecutiveBitsCount(long value) {
-    int count = 0;
-    while (value > 0) {
-       value = (value & (value << 1));
-       count++;
+// pattern id 6 bits, defence index 2 bits, direction 2 bits, miai id 5 bits
+constexpr unsigned short PATTERN_ID_MASK = 0x3F;
+constexpr unsigned short ATTACK_ID_MASK = 0xC0;
+constexpr unsigned short DIRECTION_ID_MASK = 0x300;
+constexpr unsigned short MIAI_ID_MASK = 0x7C00;
+
+constexpr short ATTACK_ID_SHIFT = 6;
+constexpr short DIRECTION_ID_SHIFT = 8;
+constexpr short MIAI_ID_SHIFT = 10;
+
+// the four lines through a point: horizontal, vertical and both diagonals
+constexpr short DIRECTIONS_COUNT = 4;
+
+static_assert(PATTERNS_COUNT <= PATTERN_ID_MASK + 1, "pattern id doesn't fit the packed template");
+static_assert(AI_PATTERN_DEFENCES_COUNT <= (ATTACK_ID_MASK >> ATTACK_ID_SHIFT) + 1, "defence index doesn't fit the packed template");
+static_assert(DIRECTIONS_COUNT <= (DIRECTION_ID_MASK >> DIRECTION_ID_SHIFT) + 1, "direction doesn't fit the packed template");
+static_assert(MIAI_IDS_COUNT <= (MIAI_ID_MASK >> MIAI_ID_SHIFT) + 1, "miai id doesn't fit the packed template");
+
+unsigned short getPackedPriority(short patternId, short attackId, short direction, short miaiId) {
+    return patternId + (attackId << ATTACK_ID_SHIFT) + (direction << DIRECTION_ID_SHIFT) + (miaiId << MIAI_ID_SHIFT);
+}
+
+// Patterns are matched on the cells around the evaluated point: 5 before it, the point itself,
+// which is always empty, and 8 after it. Every part of the window indexes a table of the patterns
+// it allows, so the patterns found on a line are the AND of three lookups.
+
+static_assert(PATTERNS_COUNT <= 64, "pattern sets are 64 bit masks");
+
+constexpr bool arePatternsOrderedByPriority() {
+    for (unsigned i = 1; i < PATTERNS_COUNT; ++i) {
+        if (MOVE_PATTERNS[i].attackPriority > MOVE_PATTERNS[i - 1].attackPriority || MOVE_PATTERNS[i].index != short(i)) {
+            return false;
+        }
     }
 
-    return count;
+    return true;
 }
 
-short getMoveHash(short x, short y) {
-    return y * BOARD_SIZE + x;
+// the lowest pattern id found wins, so it has to be the most urgent one
+static_assert(arePatternsOrderedByPriority(), "Templates.json has to list the templates by priority");
+
+// a cell with both bits set lies before the start of the line, it matches neither stones nor empty cells
+constexpr bool isCellAllowed(const AIPattern& pattern, short offset, bool own, bool enemy) {
+    auto isRequired = [offset](long bits, short shift) {
+        return offset >= shift && offset - shift < 63 && ((bits >> (offset - shift)) & 1);
+    };
+
+    if (isRequired(pattern.pattern, pattern.patternShift) && !(own && !enemy)) {
+        return false;
+    }
+    if (isRequired(pattern.emptyPattern, pattern.emptyShift) && (own || enemy)) {
+        return false;
+    }
+    if (isRequired(pattern.enemyPattern, pattern.enemyShift) && !(enemy && !own)) {
+        return false;
+    }
+
+    return true;
 }
 
-constexpr long PATTERN_ID_MASK = 0x3F;
-constexpr long ATTACK_ID_MASK = 0x1C0;
-constexpr long DIRECTION_ID_MASK = 0xE00;
-constexpr long MIAI_ID_MASK = 0x3F0000;
+constexpr bool doPatternsFitWindow() {
+    for (const auto& pattern : MOVE_PATTERNS) {
+        if (!isCellAllowed(pattern, 0, false, false)) {
+            return false;
+        }
 
-constexpr short ATTACK_ID_SHIFT = 7;
-constexpr short DIRECTION_ID_SHIFT = 9;
-constexpr short MIAI_ID_SHIFT = 16;
+        for (short offset = -16; offset <= 16; ++offset) {
+            if (offset >= -WINDOW_BEFORE_CELLS && offset <= WINDOW_AFTER_CELLS) {
+                continue;
+            }
 
-long getPackedPriority(short patternId, short attackId, short direction, short miaiId) {
-    return patternId + (attackId << ATTACK_ID_SHIFT) + (direction << DIRECTION_ID_SHIFT) + (miaiId << MIAI_ID_SHIFT);
+            if (!isCellAllowed(pattern, offset, true, false) || !isCellAllowed(pattern, offset, false, true) || !isCellAllowed(pattern, offset, false, false)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
 
-short BitField::getRandomMove() const {
-    auto rIndex = rand() % _availableMoves.size();
-    auto moveItr = _availableMoves.begin();
-    while (rIndex > 0) { moveItr++; rIndex--; }
+static_assert(doPatternsFitWindow(), "a pattern reaches past the evaluation window");
+
+// indexed by own stones of the cells, then enemy stones of the same cells
+template<short CELLS>
+constexpr std::array<uint64_t, 1 << (CELLS * 2)> generateWindowTable(short firstOffset) {
+    std::array<uint64_t, 1 << (CELLS * 2)> result = {0};
+    for (unsigned code = 0; code < result.size(); ++code) {
+        for (const auto& pattern : MOVE_PATTERNS) {
+            bool isAllowed = true;
+            for (short cell = 0; cell < CELLS && isAllowed; ++cell) {
+                isAllowed = isCellAllowed(pattern, firstOffset + cell, (code >> cell) & 1, (code >> (cell + CELLS)) & 1);
+            }
 
-    return *moveItr;
+            if (isAllowed) {
+                result[code] |= 1ull << pattern.index;
+            }
+        }
+    }
+
+    return result;
 }
 
-short BitField::getMovePriority(short hashedPosition, short color) const {
-    int priorityShift = (color - 1) * BOARD_LENGTH;
+static constexpr auto WINDOW_BEFORE_PATTERNS = generateWindowTable<WINDOW_BEFORE_CELLS>(-WINDOW_BEFORE_CELLS);
+static constexpr auto WINDOW_NEAR_PATTERNS = generateWindowTable<WINDOW_GROUP_CELLS>(1);
+static constexpr auto WINDOW_FAR_PATTERNS = generateWindowTable<WINDOW_GROUP_CELLS>(1 + WINDOW_GROUP_CELLS);
+
+constexpr short WINDOW_CELLS = WINDOW_BEFORE_CELLS + 1 + WINDOW_AFTER_CELLS;
+constexpr uint64_t WINDOW_BEFORE_MASK = (1ull << WINDOW_BEFORE_CELLS) - 1;
+constexpr uint64_t WINDOW_GROUP_MASK = (1ull << WINDOW_GROUP_CELLS) - 1;
+constexpr short WINDOW_NEAR_SHIFT = WINDOW_BEFORE_CELLS + 1;
+constexpr short WINDOW_FAR_SHIFT = WINDOW_NEAR_SHIFT + WINDOW_GROUP_CELLS;
+
+// windows of the four lines through a point in the direction ids of the templates,
+// black cells in the low WINDOW_CELLS bits, white ones above them
+using LineWindows = std::array<uint64_t, DIRECTIONS_COUNT>;
+// patterns found on every line, bit i is MOVE_PATTERNS[i]
+using LinePatterns = std::array<uint64_t, DIRECTIONS_COUNT>;
+
+#ifdef __AVX2__
+
+// the four lines go through the lanes, the tables are read with gathers
+LinePatterns getLinePatterns(const LineWindows& windows, short color) {
+    const __m256i beforeMask = _mm256_set1_epi64x(WINDOW_BEFORE_MASK);
+    const __m256i groupMask = _mm256_set1_epi64x(WINDOW_GROUP_MASK);
+
+    __m256i lines = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(windows.data()));
+    __m256i own = _mm256_srl_epi64(lines, _mm_cvtsi32_si128(color == BLACK_PIECE_COLOR ? 0 : WINDOW_CELLS));
+    __m256i enemy = _mm256_srl_epi64(lines, _mm_cvtsi32_si128(color == BLACK_PIECE_COLOR ? WINDOW_CELLS : 0));
+
+    __m256i before = _mm256_or_si256(_mm256_and_si256(own, beforeMask),
+                                     _mm256_slli_epi64(_mm256_and_si256(enemy, beforeMask), WINDOW_BEFORE_CELLS));
+    __m256i near = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi64(own, WINDOW_NEAR_SHIFT), groupMask),
+                                   _mm256_slli_epi64(_mm256_and_si256(_mm256_srli_epi64(enemy, WINDOW_NEAR_SHIFT), groupMask), WINDOW_GROUP_CELLS));
+    __m256i far = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi64(own, WINDOW_FAR_SHIFT), groupMask),
+                                  _mm256_slli_epi64(_mm256_and_si256(_mm256_srli_epi64(enemy, WINDOW_FAR_SHIFT), groupMask), WINDOW_GROUP_CELLS));
+
+    __m256i patterns = _mm256_and_si256(_mm256_i64gather_epi64(reinterpret_cast<const long long*>(WINDOW_BEFORE_PATTERNS.data()), before, 8),
+                                        _mm256_and_si256(_mm256_i64gather_epi64(reinterpret_cast<const long long*>(WINDOW_NEAR_PATTERNS.data()), near, 8),
+                                                         _mm256_i64gather_epi64(reinterpret_cast<const long long*>(WINDOW_FAR_PATTERNS.data()), far, 8)));
+
+    LinePatterns result;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(result.data()), patterns);
+
+    return result;
+}
+
+#else
+
+LinePatterns getLinePatterns(const LineWindows& windows, short color) {
+    short ownShift = color == BLACK_PIECE_COLOR ? 0 : WINDOW_CELLS;
+    short enemyShift = color == BLACK_PIECE_COLOR ? WINDOW_CELLS : 0;
+
+    LinePatterns result;
+    for (short direction = 0; direction < DIRECTIONS_COUNT; ++direction) {
+        uint64_t own = windows[direction] >> ownShift;
+        uint64_t enemy = windows[direction] >> enemyShift;
+
+        uint64_t before = (own & WINDOW_BEFORE_MASK) | ((enemy & WINDOW_BEFORE_MASK) << WINDOW_BEFORE_CELLS);
+        uint64_t near = ((own >> WINDOW_NEAR_SHIFT) & WINDOW_GROUP_MASK) | (((enemy >> WINDOW_NEAR_SHIFT) & WINDOW_GROUP_MASK) << WINDOW_GROUP_CELLS);
+        uint64_t far = ((own >> WINDOW_FAR_SHIFT) & WINDOW_GROUP_MASK) | (((enemy >> WINDOW_FAR_SHIFT) & WINDOW_GROUP_MASK) << WINDOW_GROUP_CELLS);
+
+        result[direction] = WINDOW_BEFORE_PATTERNS[before] & WINDOW_NEAR_PATTERNS[near] & WINDOW_FAR_PATTERNS[far];
+    }
+
+    return result;
+}
+
+#endif
+
+template<short SIZE>
+short BasicBitField<SIZE>::getRandomMove() const {
+    return _availableMoves.getRandomMove();
+}
+
+template<short SIZE>
+short BasicBitField<SIZE>::getMovePriority(short hashedPosition, short color) const {
+    int priorityShift = (color - 1) * LENGTH;
 
     auto myPriority = _attackingMovesPriority[hashedPosition + priorityShift];
     return myPriority;
 }
 
-short BitField::getMoveDefencePriority(short hashedPosition, short color) const {
-    int priorityShift = (color - 1) * BOARD_LENGTH;
+template<short SIZE>
+short BasicBitField<SIZE>::getMoveDefencePriority(short hashedPosition, short color) const {
+    int priorityShift = (color - 1) * LENGTH;
 
     auto myPriority = _defensiveMovesPriority[hashedPosition + priorityShift];
     return myPriority.priority;
 }
 
-short BitField::getMoveByPriority(short color) const {
-    std::array<std::vector<short>, MOVE_PRIORITIES::IMMIDIATE + 1> attackPriorities;
-    std::array<std::vector<short>, MOVE_PRIORITIES::IMMIDIATE + 1> defencePriorities;
-    short maxDefencePriority = 0, minDefencePriority = 1000;
-    short maxAttackPriority = 0, minAttackPriority = 1000;
-    for (auto& move : _availableMoves) {
-        short attackPriority = getMovePriority(move, color);
-        short defencePriority = getMoveDefencePriority(move, color);
-        attackPriorities[attackPriority].push_back(move);
-        defencePriorities[defencePriority].push_back(move);
-
-        minDefencePriority = std::max(minDefencePriority, defencePriority);
-        maxDefencePriority = std::max(maxDefencePriority, defencePriority);
-        minAttackPriority = std::max(minAttackPriority, attackPriority);
-        maxAttackPriority = std::max(maxAttackPriority, attackPriority);
-    }
+template<short SIZE>
+short BasicBitField<SIZE>::getMoveByPriority(short color) const {
+    const PriorityBuckets<LENGTH>& attackPriorities = _priorityBuckets[getAttackBucketsIndex(color)];
+    const PriorityBuckets<LENGTH>& defencePriorities = _priorityBuckets[getDefenceBucketsIndex(color)];
+    short maxDefencePriority = defencePriorities.getMaxPriority();
+    short maxAttackPriority = attackPriorities.getMaxPriority();
+    // the old scan took the minimums with std::max from 1000, the weights below depend on it
+    short minDefencePriority = 1000;
+    short minAttackPriority = 1000;
 
     if (maxAttackPriority >= MOVE_PRIORITIES::IMMIDIATE) {
-        auto rIndex = rand() % attackPriorities[maxAttackPriority].size();
-        auto moveItr = attackPriorities[maxAttackPriority].begin();
-        while (rIndex > 0) { moveItr++; rIndex--; }
-
-        return *moveItr;
+        return attackPriorities.getRandomMove(maxAttackPriority);
     }
 
     if (maxDefencePriority >= MOVE_PRIORITIES::IMMIDIATE) {
-        auto rIndex = rand() % defencePriorities[maxDefencePriority].size();
-        auto moveItr = defencePriorities[maxDefencePriority].begin();
-        while (rIndex > 0) { moveItr++; rIndex--; }
-
-        return *moveItr;
+        return defencePriorities.getRandomMove(maxDefencePriority);
     }
 
     if (maxAttackPriority >= MOVE_PRIORITIES::URGENT && maxDefencePriority < MOVE_PRIORITIES::HIGH) {
-        auto rIndex = rand() % attackPriorities[maxAttackPriority].size();
-        auto moveItr = attackPriorities[maxAttackPriority].begin();
-        while (rIndex > 0) { moveItr++; rIndex--; }
-
-        return *moveItr;
+        return attackPriorities.getRandomMove(maxAttackPriority);
     }
 
     if (maxDefencePriority >= MOVE_PRIORITIES::URGENT && maxAttackPriority < MOVE_PRIORITIES::HIGH) {
-        auto rIndex = rand() % defencePriorities[maxDefencePriority].size();
-        auto moveItr = defencePriorities[maxDefencePriority].begin();
-        while (rIndex > 0) { moveItr++; rIndex--; }
-
-        return *moveItr;
+        return defencePriorities.getRandomMove(maxDefencePriority);
     }
 
     short attackDefenceRoll = rand() % 100;
     if (maxDefencePriority >= MOVE_PRIORITIES::URGENT && maxAttackPriority >= MOVE_PRIORITIES::HIGH) {
         if (attackDefenceRoll < 50) {
-            auto rIndex = rand() % defencePriorities[maxDefencePriority].size();
-            auto moveItr = defencePriorities[maxDefencePriority].begin();
-            while (rIndex > 0) { moveItr++; rIndex--; }
-
-            return *moveItr;
+            return defencePriorities.getRandomMove(maxDefencePriority);
         } else {
-            auto rIndex = rand() % attackPriorities[maxAttackPriority].size();
-            auto moveItr = attackPriorities[maxAttackPriority].begin();
-            while (rIndex > 0) { moveItr++; rIndex--; }
-
-            return *moveItr;
+            return attackPriorities.getRandomMove(maxAttackPriority);
         }
     }
 
@@ -160,7 +278,7 @@ short BitField::getMoveByPriority(short color) const {
         short randomHit = totalPriority == 0 ? 0 : rand() % totalPriority;
         short selectedPriority = maxDefencePriority;
         for (int i = 0; i <= maxDefencePriority; ++i) {
-            if (defencePriorities[i].empty()) {
+            if (defencePriorities.isEmpty(i)) {
                 continue;;
             }
 
@@ -170,17 +288,13 @@ short BitField::getMoveByPriority(short color) const {
             }
         }
 
-        auto rIndex = rand() % defencePriorities[selectedPriority].size();
-        auto moveItr = defencePriorities[selectedPriority].begin();
-        while (rIndex > 0) { moveItr++; rIndex--; }
-
-        move = *moveItr;
+        move = defencePriorities.getRandomMove(selectedPriority);
     } else {
         short totalPriority = maxAttackPriority + minAttackPriority;
         short randomHit = totalPriority == 0 ? 0 : rand() % totalPriority;
         short selectedPriority = maxAttackPriority;
         for (int i = 0; i <= maxAttackPriority; ++i) {
-            if (attackPriorities[i].empty()) {
+            if (attackPriorities.isEmpty(i)) {
                 continue;;
             }
 
@@ -190,62 +304,49 @@ short BitField::getMoveByPriority(short color) const {
             }
         }
 
-        auto rIndex = rand() % attackPriorities[selectedPriority].size();
-        auto moveItr = attackPriorities[selectedPriority].begin();
-        while (rIndex > 0) { moveItr++; rIndex--; }
-
-        move = *moveItr;
+        move = attackPriorities.getRandomMove(selectedPriority);
     }
 
     return move;
 }
 
-std::vector<short> BitField::getBestMoves(short color) const {
-    std::vector<short> result;
-
-    std::array<std::vector<short>, MOVE_PRIORITIES::IMMIDIATE + 1> attackPriorities;
-    std::array<std::vector<short>, MOVE_PRIORITIES::IMMIDIATE + 1> defencePriorities;
-    short maxDefencePriority = 0, minDefencePriority = 1000;
-    short maxAttackPriority = 0, minAttackPriority = 1000;
-    for (auto& move : _availableMoves) {
-        short attackPriority = getMovePriority(move, color);
-        short defencePriority = getMoveDefencePriority(move, color);
-        attackPriorities[attackPriority].push_back(move);
-        defencePriorities[defencePriority].push_back(move);
-
-        minDefencePriority = std::min(minDefencePriority, defencePriority);
-        maxDefencePriority = std::max(maxDefencePriority, defencePriority);
-        minAttackPriority = std::min(minAttackPriority, attackPriority);
-        maxAttackPriority = std::max(maxAttackPriority, attackPriority);
-    }
+template<short SIZE>
+Span<short> BasicBitField<SIZE>::getBestMoves(short color, MovesBuffer& buffer) const {
+    const PriorityBuckets<LENGTH>& attackPriorities = _priorityBuckets[getAttackBucketsIndex(color)];
+    const PriorityBuckets<LENGTH>& defencePriorities = _priorityBuckets[getDefenceBucketsIndex(color)];
+    short maxDefencePriority = defencePriorities.getMaxPriority();
+    short maxAttackPriority = attackPriorities.getMaxPriority();
 
     if (maxAttackPriority >= MOVE_PRIORITIES::IMMIDIATE) {
-        return attackPriorities[maxAttackPriority];
+        return attackPriorities.getBucket(maxAttackPriority);
     }
 
     if (maxDefencePriority >= MOVE_PRIORITIES::IMMIDIATE) {
-        return defencePriorities[maxDefencePriority];
+        return defencePriorities.getBucket(maxDefencePriority);
     }
 
     if (maxAttackPriority >= MOVE_PRIORITIES::URGENT && maxDefencePriority < MOVE_PRIORITIES::HIGH) {
-        return attackPriorities[maxAttackPriority];
+        return attackPriorities.getBucket(maxAttackPriority);
     }
 
     if (maxDefencePriority >= MOVE_PRIORITIES::URGENT && maxAttackPriority < MOVE_PRIORITIES::HIGH) {
-        return defencePriorities[maxDefencePriority];
+        return defencePriorities.getBucket(maxDefencePriority);
     }
 
     if (maxDefencePriority >= MOVE_PRIORITIES::URGENT && maxAttackPriority >= MOVE_PRIORITIES::HIGH) {
-        std::copy(attackPriorities[maxAttackPriority].begin(), attackPriorities[maxAttackPriority].end(), std::back_inserter(result));
-        std::copy(defencePriorities[maxDefencePriority].begin(), defencePriorities[maxDefencePriority].end(), std::back_inserter(result));
+        auto attackMoves = attackPriorities.getBucket(maxAttackPriority);
+        auto defenceMoves = defencePriorities.getBucket(maxDefencePriority);
+        auto end = std::copy(attackMoves.begin(), attackMoves.end(), buffer.begin());
+        end = std::copy(defenceMoves.begin(), defenceMoves.end(), end);
 
-        return result;
+        return {buffer.data(), static_cast<size_t>(end - buffer.begin())};
     }
 
-    return _availableMoves;
+    return getAvailableMoves();
 }
 
-bool BitField::makeMove(short x, short y, short color) {
+template<short SIZE>
+bool BasicBitField<SIZE>::makeMove(short x, short y, short color, UndoJournal* journal) {
     if (_gameStatus != 0) {
         return false;
     }
@@ -254,110 +355,288 @@ bool BitField::makeMove(short x, short y, short color) {
 
     Debug::getInstance().trackCall(DebugCallTracks::MAKE_MOVE);
 
-    int colorShift = (color - 1) * BOARD_SIZE;
-    long horizontal = 1 << x;
-    long vertical = 1 << y;
-    unsigned long fullBoard = (_horizontals[y] | _horizontals[y + BOARD_SIZE]);
-
-    if (fullBoard & horizontal) {
+    if (!_horizontals.isEmpty(y, x)) {
         return false;
     }
 
-    _horizontals[y + colorShift] = _horizontals[y + colorShift] | horizontal;
-    _verticals[x + colorShift] = _verticals[x + colorShift] | vertical;
+    if (journal) {
+        journal->_frames.push_back({journal->_records.size(), _gameStatus});
+    }
+
+    _horizontals.set(y, x, color);
+    _verticals.set(x, y, color);
 
     auto leftDiagonal = getDiagonalLeftIndex(x, y);
-    _diagonal_left[leftDiagonal + colorShift * 2] = _diagonal_left[leftDiagonal + colorShift * 2] | vertical;
+    _diagonal_left.set(leftDiagonal, y, color);
 
     auto rightDiagonal = getDiagonalRightIndex(x, y);
-    _diagonal_right[rightDiagonal + colorShift * 2] = _diagonal_right[rightDiagonal + colorShift * 2] | vertical;
+    _diagonal_right.set(rightDiagonal, y, color);
 
-    _history.push_back(std::make_tuple(x, y, color));
+    _history[_historySize++] = {x, y, color};
 
-    if ((_horizontals[y] | _horizontals[y + BOARD_SIZE]) == FILLED_ROW_BITS) {
-        _filledHorizontals = _filledHorizontals | (1 << y);
-    }
+    _hash ^= getZobristKey(Geometry::getHashedPosition(x, y), color);
+    assert(_hash == computeHash());
 
-    if (getConsecutiveBitsCount(_horizontals[y + colorShift]) >= MOVES_IN_ROW_TO_WIN) {
+    // a row can only be completed through the new stone
+    if (_horizontals.hasRowOfFive(y, x, color) || _verticals.hasRowOfFive(x, y, color) ||
+            _diagonal_left.hasRowOfFive(leftDiagonal, y, color) || _diagonal_right.hasRowOfFive(rightDiagonal, y, color)) {
         _gameStatus = color;
         return true;
     }
 
-    if (getConsecutiveBitsCount(_verticals[x + colorShift]) >= MOVES_IN_ROW_TO_WIN) {
-        _gameStatus = color;
-        return true;
-    }
-
-    if (getConsecutiveBitsCount(_diagonal_left[leftDiagonal + colorShift * 2]) >= MOVES_IN_ROW_TO_WIN) {
-        _gameStatus = color;
-        return true;
-    }
-
-    if (getConsecutiveBitsCount(_diagonal_right[rightDiagonal + colorShift * 2]) >= MOVES_IN_ROW_TO_WIN) {
-        _gameStatus = color;
-        return true;
-    }
-
-    if (_filledHorizontals == FILLED_ROW_BITS) {
+    if (_historySize == LENGTH) {
         _gameStatus = -1;
         return true;
     }
 
     Debug::getInstance().startTrack(DebugTimeTracks::INCREMENTAL_UPDATE);
-    incrementalUpdate(x, y, color);
+    incrementalUpdate(x, y, color, journal);
     Debug::getInstance().stopTrack(DebugTimeTracks::INCREMENTAL_UPDATE);
 
     Debug::getInstance().stopTrack(DebugTimeTracks::MAKE_MOVE);
     return true;
 }
 
-bool BitField::unmakeMove() {
-    if (_history.empty()) {
+template<short SIZE>
+bool BasicBitField<SIZE>::unmakeMove(UndoJournal& journal) {
+    if (journal.empty() || _historySize == 0) {
         return false;
     }
 
-    auto move = _history.back();
-    _history.pop_back();
+    const HistoryMove& move = _history[--_historySize];
+    short x = move[0];
+    short y = move[1];
+    short color = move[2];
+
+    _horizontals.reset(y, x, color);
+    _verticals.reset(x, y, color);
+    _diagonal_left.reset(getDiagonalLeftIndex(x, y), y, color);
+    _diagonal_right.reset(getDiagonalRightIndex(x, y), y, color);
+
+    _hash ^= getZobristKey(Geometry::getHashedPosition(x, y), color);
+    assert(_hash == computeHash());
+
+    const typename UndoJournal::MoveFrame& frame = journal._frames.back();
+    while (journal._records.size() > frame.journalSize) {
+        const typename UndoJournal::UndoRecord& record = journal._records.back();
+        switch (record.type) {
+        case UndoJournal::UndoType::AVAILABLE_MOVE_ADDED:
+            _availableMoves.erase(record.value);
+            for (short bucketsIndex = 0; bucketsIndex < static_cast<short>(_priorityBuckets.size()); ++bucketsIndex) {
+                _priorityBuckets[bucketsIndex].undoInsert(record.value, getBucketPriority(bucketsIndex, record.value));
+            }
+            break;
+        case UndoJournal::UndoType::AVAILABLE_MOVE_REMOVED:
+            _availableMoves.insert(record.value, record.index);
+            break;
+        case UndoJournal::UndoType::BUCKET_MOVE_REMOVED:
+            _priorityBuckets[record.key].undoErase(record.value, getBucketPriority(record.key, record.value), record.index);
+            break;
+        case UndoJournal::UndoType::ATTACK_PRIORITY:
+            restoreAttackPriority(record.key, record.value, record.index);
+            break;
+        case UndoJournal::UndoType::DEFENCE_PRIORITY:
+            restoreDefencePriority(record.key, record.value, record.index);
+            break;
+        case UndoJournal::UndoType::DEFENCE_PATTERN_ADDED:
+            _defensiveMovesPriority[record.key].patternsCount--;
+            break;
+        case UndoJournal::UndoType::DEFENCE_PATTERN_REMOVED:
+            auto& defensiveMove = _defensiveMovesPriority[record.key];
+            auto patterns = defensiveMove.patterns.begin();
+            std::copy_backward(patterns + record.index, patterns + defensiveMove.patternsCount, patterns + defensiveMove.patternsCount + 1);
+            defensiveMove.patterns[record.index] = record.value;
+            defensiveMove.patternsCount++;
+            break;
+        }
+        journal._records.pop_back();
+    }
 
-    short x = std::get<0>(move);
-    short y = std::get<1>(move);
-    short color = std::get<2>(move);
+    _gameStatus = frame.gameStatus;
+    journal._frames.pop_back();
 
-    int colorShift = (color -1) * BOARD_SIZE;
-    long horizontal = ~(1 << x);
-    long vertical = ~(1 << y);
+    return true;
+}
 
-    _horizontals[y + colorShift] = _horizontals[y + colorShift] & horizontal;
-    _verticals[x + colorShift] = _verticals[x + colorShift] & vertical;
+template<short SIZE>
+void BasicBitField<SIZE>::insertAvailableMove(short move, unsigned short index) {
+    _availableMoves.insert(move, index);
 
-    auto leftDiagonal = getDiagonalLeftIndex(x, y);
-    _diagonal_left[leftDiagonal + colorShift * 2] = _diagonal_left[leftDiagonal + colorShift * 2] & vertical;
+    for (short color = BLACK_PIECE_COLOR; color <= WHITE_PIECE_COLOR; ++color) {
+        short key = move + (color - 1) * LENGTH;
+        _priorityBuckets[getAttackBucketsIndex(color)].insert(move, _attackingMovesPriority[key]);
+        _priorityBuckets[getDefenceBucketsIndex(color)].insert(move, _defensiveMovesPriority[key].priority);
+    }
+}
 
-    auto rightDiagonal = getDiagonalRightIndex(x, y);
-    _diagonal_right[rightDiagonal + colorShift * 2] = _diagonal_right[rightDiagonal + colorShift * 2] & vertical;
+template<short SIZE>
+unsigned short BasicBitField<SIZE>::eraseAvailableMove(short move) {
+    unsigned short index = _availableMoves.erase(move);
+
+    for (short color = BLACK_PIECE_COLOR; color <= WHITE_PIECE_COLOR; ++color) {
+        short key = move + (color - 1) * LENGTH;
+        _priorityBuckets[getAttackBucketsIndex(color)].erase(move, _attackingMovesPriority[key]);
+        _priorityBuckets[getDefenceBucketsIndex(color)].erase(move, _defensiveMovesPriority[key].priority);
+    }
+
+    return index;
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::writeAttackPriority(short key, unsigned char priority) {
+    short move = key % LENGTH;
+    if (_availableMoves.contains(move)) {
+        _priorityBuckets[getAttackBucketsIndex(key / LENGTH + 1)].update(move, _attackingMovesPriority[key], priority);
+    }
+    _attackingMovesPriority[key] = priority;
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::writeDefencePriority(short key, unsigned short priority) {
+    short move = key % LENGTH;
+    if (_availableMoves.contains(move)) {
+        _priorityBuckets[getDefenceBucketsIndex(key / LENGTH + 1)].update(move, _defensiveMovesPriority[key].priority, priority);
+    }
+    _defensiveMovesPriority[key].priority = priority;
+}
+
+template<short SIZE>
+short BasicBitField<SIZE>::getBucketSlot(short bucketsIndex, short move) const {
+    return _availableMoves.contains(move) ? _priorityBuckets[bucketsIndex].getIndex(move) : 0;
+}
+
+template<short SIZE>
+unsigned short BasicBitField<SIZE>::getBucketPriority(short bucketsIndex, short move) const {
+    // attack and defence buckets alternate, a pair per color
+    short key = move + bucketsIndex / 2 * LENGTH;
+    return bucketsIndex % 2 == 0 ? _attackingMovesPriority[key] : _defensiveMovesPriority[key].priority;
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::restoreAttackPriority(short key, unsigned char priority, short slot) {
+    short move = key % LENGTH;
+    if (_availableMoves.contains(move)) {
+        _priorityBuckets[getAttackBucketsIndex(key / LENGTH + 1)].undoUpdate(move, priority, _attackingMovesPriority[key], slot);
+    }
+    _attackingMovesPriority[key] = priority;
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::restoreDefencePriority(short key, unsigned short priority, short slot) {
+    short move = key % LENGTH;
+    if (_availableMoves.contains(move)) {
+        _priorityBuckets[getDefenceBucketsIndex(key / LENGTH + 1)].undoUpdate(move, priority, _defensiveMovesPriority[key].priority, slot);
+    }
+    _defensiveMovesPriority[key].priority = priority;
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::addAvailableMove(short move, UndoJournal* journal) {
+    insertAvailableMove(move, _availableMoves.size());
+    if (journal) {
+        journal->_records.push_back({UndoJournal::UndoType::AVAILABLE_MOVE_ADDED, 0, 0, static_cast<unsigned short>(move)});
+    }
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::removeAvailableMove(short move, UndoJournal* journal) {
+    if (journal) {
+        for (short bucketsIndex = 0; bucketsIndex < static_cast<short>(_priorityBuckets.size()); ++bucketsIndex) {
+            journal->_records.push_back({UndoJournal::UndoType::BUCKET_MOVE_REMOVED, bucketsIndex, getBucketSlot(bucketsIndex, move), static_cast<unsigned short>(move)});
+        }
+    }
+
+    short index = static_cast<short>(eraseAvailableMove(move));
+    if (journal) {
+        journal->_records.push_back({UndoJournal::UndoType::AVAILABLE_MOVE_REMOVED, 0, index, static_cast<unsigned short>(move)});
+    }
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::setAttackPriority(short key, unsigned char priority, UndoJournal* journal) {
+    if (_attackingMovesPriority[key] == priority) {
+        return;
+    }
+
+    if (journal) {
+        short slot = getBucketSlot(getAttackBucketsIndex(key / LENGTH + 1), key % LENGTH);
+        journal->_records.push_back({UndoJournal::UndoType::ATTACK_PRIORITY, key, slot, _attackingMovesPriority[key]});
+    }
+    writeAttackPriority(key, priority);
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::setDefencePriority(short key, unsigned short priority, UndoJournal* journal) {
+    if (_defensiveMovesPriority[key].priority == priority) {
+        return;
+    }
+
+    if (journal) {
+        short slot = getBucketSlot(getDefenceBucketsIndex(key / LENGTH + 1), key % LENGTH);
+        journal->_records.push_back({UndoJournal::UndoType::DEFENCE_PRIORITY, key, slot, _defensiveMovesPriority[key].priority});
+    }
+    writeDefencePriority(key, priority);
+}
+
+template<short SIZE>
+bool BasicBitField<SIZE>::addDefencePattern(short key, unsigned short pattern, UndoJournal* journal) {
+    auto& defensiveMove = _defensiveMovesPriority[key];
+    assert(defensiveMove.patternsCount < DEFENCE_PATTERNS_CAPACITY);
+    if (defensiveMove.patternsCount == DEFENCE_PATTERNS_CAPACITY) {
+        return false;
+    }
+
+    defensiveMove.patterns[defensiveMove.patternsCount++] = pattern;
+    if (journal) {
+        journal->_records.push_back({UndoJournal::UndoType::DEFENCE_PATTERN_ADDED, key, 0, 0});
+    }
 
     return true;
 }
 
-void BitField::incrementalUpdate(short x, short y, short color) {
-    Debug::getInstance().startTrack(DebugTimeTracks::ERASE_AVAILABLE_MOVES);
-    auto moveHash = getMoveHash(x, y);
-    if (_availableMovesHash.test(moveHash)) {
-        _availableMovesHash.flip(moveHash);
+template<short SIZE>
+void BasicBitField<SIZE>::removeDefencePattern(short key, unsigned index, UndoJournal* journal) {
+    auto& defensiveMove = _defensiveMovesPriority[key];
+    if (journal) {
+        journal->_records.push_back({UndoJournal::UndoType::DEFENCE_PATTERN_REMOVED, key, static_cast<short>(index), defensiveMove.patterns[index]});
+    }
+
+    auto patterns = defensiveMove.patterns.begin();
+    std::copy(patterns + index + 1, patterns + defensiveMove.patternsCount, patterns + index);
+    defensiveMove.patternsCount--;
+}
 
-        auto it =  std::find(_availableMoves.begin(), _availableMoves.end(), moveHash);
-        if (it != _availableMoves.end()) {
-            _availableMoves.erase(it);
+template<short SIZE>
+uint64_t BasicBitField<SIZE>::computeHash() const {
+    uint64_t hash = 0;
+    for (short color = BLACK_PIECE_COLOR; color <= WHITE_PIECE_COLOR; ++color) {
+        for (short y = 0; y < SIZE; ++y) {
+            for (short x = 0; x < SIZE; ++x) {
+                if (_horizontals.hasStone(y, x, color)) {
+                    hash ^= getZobristKey(Geometry::getHashedPosition(x, y), color);
+                }
+            }
         }
     }
+
+    return hash;
+}
+
+template<short SIZE>
+void BasicBitField<SIZE>::incrementalUpdate(short x, short y, short color, UndoJournal* journal) {
+    Debug::getInstance().startTrack(DebugTimeTracks::ERASE_AVAILABLE_MOVES);
+    auto moveHash = Geometry::getHashedPosition(x, y);
+    if (_availableMoves.contains(moveHash)) {
+        removeAvailableMove(moveHash, journal);
+    }
     Debug::getInstance().stopTrack(DebugTimeTracks::ERASE_AVAILABLE_MOVES);
 
     Debug::getInstance().startTrack(DebugTimeTracks::CLEAR_TEMPLATES);
     // clear defensive moves
-    int priorityShift = (color - 1) * BOARD_LENGTH;
+    int priorityShift = (color - 1) * LENGTH;
     short parentDefensiveHash = moveHash + priorityShift;
-    for (auto patternIt = _defensiveMovesPriority[parentDefensiveHash].patterns.begin(); patternIt != _defensiveMovesPriority[parentDefensiveHash].patterns.end();) {
-        long pattern = *patternIt;
+    for (unsigned patternIndex = 0; patternIndex < _defensiveMovesPriority[parentDefensiveHash].patternsCount;) {
+        long pattern = _defensiveMovesPriority[parentDefensiveHash].patterns[patternIndex];
         short patternId = (pattern & PATTERN_ID_MASK);
         short patternDirection = (pattern & DIRECTION_ID_MASK) >> DIRECTION_ID_SHIFT;
         short attackIndex = (pattern & ATTACK_ID_MASK) >> ATTACK_ID_SHIFT;
@@ -387,33 +666,33 @@ void BitField::incrementalUpdate(short x, short y, short color) {
                 resetY += resetShift;
             }
 
-            if (resetX < 0 || resetY < 0 || resetX >= BOARD_SIZE || resetY >= BOARD_SIZE) {
+            if (resetX < 0 || resetY < 0 || resetX >= SIZE || resetY >= SIZE) {
                 continue;
             }
 
-            short resetHash = getMoveHash(resetX, resetY);
+            short resetHash = Geometry::getHashedPosition(resetX, resetY);
             long resetPatternHash = (pattern & (PATTERN_ID_MASK | MIAI_ID_MASK | DIRECTION_ID_MASK)) | (i << ATTACK_ID_SHIFT);
             short key = resetHash + priorityShift;
-            auto it = std::find_if(_defensiveMovesPriority[key].patterns.begin(), _defensiveMovesPriority[key].patterns.end(), [resetPatternHash](auto& value) {
+            auto it = std::find_if(_defensiveMovesPriority[key].begin(), _defensiveMovesPriority[key].end(), [resetPatternHash](auto& value) {
                 return (value & DIRECTION_ID_MASK) == (resetPatternHash & DIRECTION_ID_MASK) && (value & MIAI_ID_MASK) == (resetPatternHash & MIAI_ID_MASK);
             });
-            if (it == _defensiveMovesPriority[key].patterns.end()) {
+            if (it == _defensiveMovesPriority[key].end()) {
                 continue;
             }
 
-            if (key != parentDefensiveHash) _defensiveMovesPriority[key].patterns.erase(it);
+            if (key != parentDefensiveHash) removeDefencePattern(key, it - _defensiveMovesPriority[key].begin(), journal);
             else shouldDeleteKey = true;
 
             unsigned maxPriority = 0;
-            for (auto& resetPattern : _defensiveMovesPriority[key].patterns) {
+            for (auto& resetPattern : _defensiveMovesPriority[key]) {
                 short moveId = (resetPattern & PATTERN_ID_MASK);
                 maxPriority = std::max(MOVE_PATTERNS[moveId].attackPriority, maxPriority);
             }
-            _defensiveMovesPriority[key].priority = maxPriority;
+            setDefencePriority(key, maxPriority, journal);
         }
 
-        if (shouldDeleteKey) patternIt = _defensiveMovesPriority[parentDefensiveHash].patterns.erase(patternIt);
-        else ++patternIt;
+        if (shouldDeleteKey) removeDefencePattern(parentDefensiveHash, patternIndex, journal);
+        else ++patternIndex;
     }
 
     Debug::getInstance().stopTrack(DebugTimeTracks::CLEAR_TEMPLATES);
@@ -428,31 +707,29 @@ void BitField::incrementalUpdate(short x, short y, short color) {
         for (int jump = 1; jump <= 2; ++jump) {
             short newX = x + dir.first * jump;
             short newY = y + dir.second * jump;
-            if (newX < 0 || newY < 0 || newX >= BOARD_SIZE || newY >= BOARD_SIZE) {
+            if (newX < 0 || newY < 0 || newX >= SIZE || newY >= SIZE) {
                 continue;
             }
 
             generatedMoves.clear();
 
-            auto newMoveHash = getMoveHash(newX, newY);
-            unsigned long fullBoard = (_horizontals[newY] | _horizontals[newY + BOARD_SIZE]);
-            bool isPositionEmpty = (fullBoard & (1 << newX)) == 0;
+            auto newMoveHash = Geometry::getHashedPosition(newX, newY);
+            bool isPositionEmpty = _horizontals.isEmpty(newY, newX);
             if (isPositionEmpty) {
-                updateMovePriority(newX, newY, generatedMoves);
+                updateMovePriority(newX, newY, generatedMoves, journal);
             } else if (jump == 2) {
                 for (int i = jump + 1; i <= MOVES_IN_ROW_TO_WIN + jump + 1; ++i) {
                     short raycastX = x + dir.first * i;
                     short raycastY = y + dir.second * i;
-                    if (raycastX < 0 || raycastY < 0 || raycastX >= BOARD_SIZE || raycastY >= BOARD_SIZE) {
+                    if (raycastX < 0 || raycastY < 0 || raycastX >= SIZE || raycastY >= SIZE) {
                         break;
                     }
 
-                    unsigned long raycastFullBoard = (_horizontals[raycastY] | _horizontals[raycastY + BOARD_SIZE]);
-                    if ((raycastFullBoard & (1 << raycastX)) != 0) {
+                    if (!_horizontals.isEmpty(raycastY, raycastX)) {
                         continue;
                     }
 
-                    updateMovePriority(raycastX, raycastY, generatedMoves);
+                    updateMovePriority(raycastX, raycastY, generatedMoves, journal);
                     break;
                 }
             }
@@ -466,18 +743,15 @@ void BitField::incrementalUpdate(short x, short y, short color) {
             }
 
             for (auto& move : generatedMoves) {
-                if (_availableMovesHash.test(move)) {
+                if (_availableMoves.contains(move)) {
                     continue;
                 }
 
-                unsigned long fullBoard2 = (_horizontals[extractHashedPositionY(move)] |_horizontals[extractHashedPositionY(move) + BOARD_SIZE]);
-                bool isPositionEmpty2 = (fullBoard2 & (1 << extractHashedPositionX(move))) == 0;
-                if (!isPositionEmpty2) {
+                if (!_horizontals.isEmpty(Geometry::extractY(move), Geometry::extractX(move))) {
                     continue;
                 }
 
-                _availableMovesHash.set(move);
-                _availableMoves.push_back(move);
+                addAvailableMove(move, journal);
             }
         }
     }
@@ -485,312 +759,108 @@ void BitField::incrementalUpdate(short x, short y, short color) {
     Debug::getInstance().stopTrack(DebugTimeTracks::ADD_NEW_MOVES);
 }
 
-void BitField::createTemplate(short x, short y, short colorShift, short patternId, short attackId, short directionId, short miaiId, short priority, std::vector<short>& newMoves) {
-    if (x < 0 || y < 0 || x >= BOARD_SIZE || y >= BOARD_SIZE) {
+template<short SIZE>
+void BasicBitField<SIZE>::createTemplate(short x, short y, short colorShift, short patternId, short attackId, short directionId, short miaiId, short priority, std::vector<short>& newMoves, UndoJournal* journal) {
+    if (x < 0 || y < 0 || x >= SIZE || y >= SIZE) {
         return;
     }
 
     Debug::getInstance().startTrack(DebugTimeTracks::CREATE_TEMPLATE);
     Debug::getInstance().trackCall(DebugCallTracks::CREATE_TEMPLATE);
 
-    short defenceMove = getHashedPosition(x, y);
+    short defenceMove = Geometry::getHashedPosition(x, y);
     short key = defenceMove + colorShift;
-    unsigned long patternValue = getPackedPriority(patternId, attackId, directionId, miaiId);
-    if (std::find_if(_defensiveMovesPriority[key].patterns.begin(), _defensiveMovesPriority[key].patterns.end(), [patternValue](auto& value) {
+    unsigned short patternValue = getPackedPriority(patternId, attackId, directionId, miaiId);
+    if (std::find_if(_defensiveMovesPriority[key].begin(), _defensiveMovesPriority[key].end(), [patternValue](auto& value) {
         return (value & DIRECTION_ID_MASK) == (patternValue & DIRECTION_ID_MASK) && (value & MIAI_ID_MASK) == (patternValue & MIAI_ID_MASK);
-    }) != _defensiveMovesPriority[key].patterns.end()) {
+    }) != _defensiveMovesPriority[key].end()) {
         return;
     }
-    _defensiveMovesPriority[key].patterns.push_back(patternValue);
-    _defensiveMovesPriority[key].updatePriorityFast(priority);
-    newMoves.push_back(defenceMove);
+    if (addDefencePattern(key, patternValue, journal)) {
+        setDefencePriority(key, std::max<unsigned short>(priority, _defensiveMovesPriority[key].priority), journal);
+        newMoves.push_back(defenceMove);
+    }
 
     Debug::getInstance().stopTrack(DebugTimeTracks::CREATE_TEMPLATE);
 
 //    qDebug() << "add defence pattern " << colorShift << x << y << defenceMove << priority << patternId << attackId << patternValue;
 }
 
-void BitField::updateMovePriority(short x, short y, std::vector<short>& newMoves) {
+template<short SIZE>
+void BasicBitField<SIZE>::updateMovePriority(short x, short y, std::vector<short>& newMoves, UndoJournal* journal) {
     Debug::getInstance().startTrack(DebugTimeTracks::UPDATE_TEMPLATES);
     Debug::getInstance().trackCall(DebugCallTracks::UPDATE_TEMPLATES);
 
-    int blackPriorityShift = (BLACK_PIECE_COLOR - 1) * BOARD_LENGTH;
-    int whitePriorityShift = (WHITE_PIECE_COLOR - 1) * BOARD_LENGTH;
+    int blackPriorityShift = (BLACK_PIECE_COLOR - 1) * LENGTH;
+    int whitePriorityShift = (WHITE_PIECE_COLOR - 1) * LENGTH;
+
+    auto moveHash = Geometry::getHashedPosition(x, y);
+    assert(_horizontals.isEmpty(y, x));
 
-    int blackColorShift = (BLACK_PIECE_COLOR - 1) * BOARD_SIZE;
-    int whiteColorShift = (WHITE_PIECE_COLOR - 1) * BOARD_SIZE;
+    auto leftDiagonal = getDiagonalLeftIndex(x, y);
+    auto rightDiagonal = getDiagonalRightIndex(x, y);
 
-    auto moveHash = getMoveHash(x, y);
+    const LineWindows windows = {
+        _horizontals.template getWindow<WINDOW_BEFORE_CELLS, WINDOW_AFTER_CELLS>(y, x),
+        _verticals.template getWindow<WINDOW_BEFORE_CELLS, WINDOW_AFTER_CELLS>(x, y),
+        _diagonal_left.template getWindow<WINDOW_BEFORE_CELLS, WINDOW_AFTER_CELLS>(leftDiagonal, y),
+        _diagonal_right.template getWindow<WINDOW_BEFORE_CELLS, WINDOW_AFTER_CELLS>(rightDiagonal, y)
+    };
+
+    Debug::getInstance().trackCall(DebugCallTracks::UPDATE_TEMPLATES_INLINE);
+    const std::array<LinePatterns, 2> linePatterns = {
+        getLinePatterns(windows, BLACK_PIECE_COLOR),
+        getLinePatterns(windows, WHITE_PIECE_COLOR)
+    };
+
+    uint64_t allPatterns = 0;
+    for (short direction = 0; direction < DIRECTIONS_COUNT; ++direction) {
+        allPatterns |= linePatterns[0][direction] | linePatterns[1][direction];
+    }
 
     unsigned blackPriority = 0;
     unsigned whitePriority = 0;
 
-    short updatedPatterns = 0;
-
-    static constexpr short BLACK_HORIZONTAL = 1;
-    static constexpr short WHITE_HORIZONTAL = 2;
-    static constexpr short BLACK_VERTICAL = 4;
-    static constexpr short WHITE_VERTICAL = 8;
-    static constexpr short BLACK_DIAGONAL_LEFT = 16;
-    static constexpr short WHITE_DIAGONAL_LEFT = 32;
-    static constexpr short BLACK_DIAGONAL_RIGHT = 64;
-    static constexpr short WHITE_DIAGONAL_RIGHT = 128;
-    static constexpr short FULL_PATTERN_MASK = 255;
-
-    for (const auto& pattern : MOVE_PATTERNS) {
-
-        Debug::getInstance().trackCall(DebugCallTracks::UPDATE_TEMPLATES_INLINE);
-
-        bool fitHorizontal = (x + pattern.patternShift) >= 0 && (x + pattern.emptyShift) >= 0;
-        bool fitVertical = (y + pattern.patternShift) >= 0 && (y + pattern.emptyShift) >= 0;
-
-        long stringValueBlack = 0;
-        long stringValueWhite = 0;
-        long emptyStringValue = 0;
-
-        long shiftedPattern = 0;
-        long shiftedEmptyPattern = 0;
-        long shiftedEnemyPattern = 0;
-
-        if (fitHorizontal) {
-            stringValueBlack = _horizontals[y + blackColorShift];
-            stringValueWhite = _horizontals[y + whiteColorShift];
-
-            emptyStringValue = ~(stringValueBlack | stringValueWhite);
-
-            shiftedPattern = pattern.pattern << (x + pattern.patternShift);
-            shiftedEmptyPattern = pattern.emptyPattern << (x + pattern.emptyShift);
-            shiftedEnemyPattern = pattern.enemyPattern << (x + pattern.enemyShift);
-
-            if (!(updatedPatterns & BLACK_HORIZONTAL) && (shiftedPattern & stringValueBlack) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueWhite) == shiftedEnemyPattern) {
-                blackPriority = blackPriority < pattern.attackPriority ? pattern.attackPriority : blackPriority;
-
-                updatedPatterns = updatedPatterns | BLACK_HORIZONTAL;
-                for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
-                    if (pattern.defence[i] == 0 && i > 0) {
-                        break;
-                    }
-                    short defX = x + pattern.defence[i], defY = y;
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
-                        continue;
-                    }
-
-                    createTemplate(defX, defY, whitePriorityShift, pattern.index, i, 0, pattern.miaiId, pattern.attackPriority, newMoves);
-                }
-            }
-            if (!(updatedPatterns & WHITE_HORIZONTAL) && (shiftedPattern & stringValueWhite) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueBlack) == shiftedEnemyPattern) {
-                whitePriority = whitePriority < pattern.attackPriority ? pattern.attackPriority : whitePriority;
-
-                updatedPatterns = updatedPatterns | WHITE_HORIZONTAL;
-                for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
-                    if (pattern.defence[i] == 0 && i > 0) {
-                        break;
-                    }
-                    short defX = x + pattern.defence[i], defY = y;
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
-                        continue;
-                    }
-
-                    createTemplate(defX, defY, blackPriorityShift, pattern.index, i, 0, pattern.miaiId, pattern.attackPriority, newMoves);
-                }
-            }
-        }
-
-        if (fitVertical) {
-            stringValueBlack = _verticals[x + blackColorShift];
-            stringValueWhite = _verticals[x + whiteColorShift];
-
-            emptyStringValue = ~(stringValueBlack | stringValueWhite);
+    if (allPatterns) {
+        // only the first pattern found on any line counts
+        const auto& pattern = MOVE_PATTERNS[__builtin_ctzll(allPatterns)];
+        constexpr std::array<std::pair<short, short>, DIRECTIONS_COUNT> DIRECTION_STEPS = {{
+            {1, 0}, {0, 1}, {1, 1}, {-1, 1}
+        }};
 
-            shiftedPattern = pattern.pattern << (y + pattern.patternShift);
-            shiftedEmptyPattern = pattern.emptyPattern << (y + pattern.emptyShift);
-            shiftedEnemyPattern = pattern.enemyPattern << (y + pattern.enemyShift);
-
-            if (!(updatedPatterns & BLACK_VERTICAL) && (shiftedPattern & stringValueBlack) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueWhite) == shiftedEnemyPattern) {
-                blackPriority = blackPriority < pattern.attackPriority ? pattern.attackPriority : blackPriority;
-
-                updatedPatterns = updatedPatterns | BLACK_VERTICAL;
-                for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
-                    if (pattern.defence[i] == 0 && i > 0) {
-                        break;
-                    }
-                    short defX = x, defY = y + pattern.defence[i];
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
-                        continue;
-                    }
-
-                    createTemplate(defX, defY, whitePriorityShift, pattern.index, i, 1, pattern.miaiId, pattern.attackPriority, newMoves);
-                }
-            }
-            if (!(updatedPatterns & WHITE_VERTICAL) && (shiftedPattern & stringValueWhite) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueBlack) == shiftedEnemyPattern) {
-                whitePriority = whitePriority < pattern.attackPriority ? pattern.attackPriority : whitePriority;
-
-                updatedPatterns = updatedPatterns | WHITE_VERTICAL;
-                for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
-                    if (pattern.defence[i] == 0 && i > 0) {
-                        break;
-                    }
-                    short defX = x, defY = y + pattern.defence[i];
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
-                        continue;
-                    }
-
-                    createTemplate(defX, defY, blackPriorityShift, pattern.index, i, 1, pattern.miaiId, pattern.attackPriority, newMoves);
-                }
-            }
-        }
-
-        if (fitVertical) {
-            auto leftDiagonal = getDiagonalLeftIndex(x, y);
-
-            stringValueBlack = _diagonal_left[leftDiagonal + blackColorShift * 2];
-            stringValueWhite = _diagonal_left[leftDiagonal + whiteColorShift * 2];
-
-            emptyStringValue = ~(stringValueBlack | stringValueWhite);
-
-            shiftedPattern = pattern.pattern << (y + pattern.patternShift);
-            shiftedEmptyPattern = pattern.emptyPattern << (y + pattern.emptyShift);
-            shiftedEnemyPattern = pattern.enemyPattern << (y + pattern.enemyShift);
-
-            if (!(updatedPatterns & BLACK_DIAGONAL_LEFT) && (shiftedPattern & stringValueBlack) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueWhite) == shiftedEnemyPattern) {
-                blackPriority = blackPriority < pattern.attackPriority ? pattern.attackPriority : blackPriority;
-
-                updatedPatterns = updatedPatterns | BLACK_DIAGONAL_LEFT;
-                for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
-                    if (pattern.defence[i] == 0 && i > 0) {
-                        break;
-                    }
-                    short defX = x + pattern.defence[i], defY = y + pattern.defence[i];
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
-                        continue;
-                    }
-
-                    createTemplate(defX, defY, whitePriorityShift, pattern.index, i, 2, pattern.miaiId, pattern.attackPriority, newMoves);
-                }
-            }
-            if (!(updatedPatterns & WHITE_DIAGONAL_LEFT) && (shiftedPattern & stringValueWhite) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueBlack) == shiftedEnemyPattern) {
-                whitePriority = whitePriority < pattern.attackPriority ? pattern.attackPriority : whitePriority;
-
-                updatedPatterns = updatedPatterns | WHITE_DIAGONAL_LEFT;
-                for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
-                    if (pattern.defence[i] == 0 && i > 0) {
-                        break;
-                    }
-                    short defX = x + pattern.defence[i], defY = y + pattern.defence[i];
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
-                        continue;
-                    }
-
-                    createTemplate(defX, defY, blackPriorityShift, pattern.index, i, 2, pattern.miaiId, pattern.attackPriority, newMoves);
+        for (short direction = 0; direction < DIRECTIONS_COUNT; ++direction) {
+            for (short color = BLACK_PIECE_COLOR; color <= WHITE_PIECE_COLOR; ++color) {
+                if (!(linePatterns[color - 1][direction] & (1ull << pattern.index))) {
+                    continue;
                 }
-            }
-        }
-
-        if (fitVertical) {
-            auto rightDiagonal = getDiagonalRightIndex(x, y);
-
-            stringValueBlack = _diagonal_right[rightDiagonal + blackColorShift * 2];
-            stringValueWhite = _diagonal_right[rightDiagonal + whiteColorShift * 2];
 
-            emptyStringValue = ~(stringValueBlack | stringValueWhite);
+                unsigned& priority = color == BLACK_PIECE_COLOR ? blackPriority : whitePriority;
+                priority = pattern.attackPriority;
 
-            shiftedPattern = pattern.pattern << (y + pattern.patternShift);
-            shiftedEmptyPattern = pattern.emptyPattern << (y + pattern.emptyShift);
-            shiftedEnemyPattern = pattern.enemyPattern << (y + pattern.enemyShift);
-
-            if (!(updatedPatterns & BLACK_DIAGONAL_RIGHT) && (shiftedPattern & stringValueBlack) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueWhite) == shiftedEnemyPattern) {
-                blackPriority = blackPriority < pattern.attackPriority ? pattern.attackPriority : blackPriority;
-
-                updatedPatterns = updatedPatterns | BLACK_DIAGONAL_RIGHT;
-                for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
-                    if (pattern.defence[i] == 0 && i > 0) {
-                        break;
-                    }
-                    short defX = x - pattern.defence[i], defY = y + pattern.defence[i];
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
-                        continue;
-                    }
-
-                    createTemplate(defX, defY, whitePriorityShift, pattern.index, i, 3, pattern.miaiId, pattern.attackPriority, newMoves);
-                }
-            }
-            if (!(updatedPatterns & WHITE_DIAGONAL_RIGHT) && (shiftedPattern & stringValueWhite) == shiftedPattern && (emptyStringValue & shiftedEmptyPattern) == shiftedEmptyPattern && (shiftedEnemyPattern & stringValueBlack) == shiftedEnemyPattern) {
-                whitePriority = whitePriority < pattern.attackPriority ? pattern.attackPriority : whitePriority;
-
-                updatedPatterns = updatedPatterns | WHITE_DIAGONAL_RIGHT;
+                // templates are made for the other player
+                int defenceShift = color == BLACK_PIECE_COLOR ? whitePriorityShift : blackPriorityShift;
                 for (int i = 0; i < AI_PATTERN_DEFENCES_COUNT; ++i) {
                     if (pattern.defence[i] == 0 && i > 0) {
                         break;
                     }
-                    short defX = x - pattern.defence[i], defY = y + pattern.defence[i];
-                    if (defX < 0 || defY < 0 || defX >= BOARD_SIZE || defY >= BOARD_SIZE) {
+                    short defX = x + DIRECTION_STEPS[direction].first * pattern.defence[i];
+                    short defY = y + DIRECTION_STEPS[direction].second * pattern.defence[i];
+                    if (defX < 0 || defY < 0 || defX >= SIZE || defY >= SIZE) {
                         continue;
                     }
 
-                    createTemplate(defX, defY, blackPriorityShift, pattern.index, i, 3, pattern.miaiId, pattern.attackPriority, newMoves);
+                    createTemplate(defX, defY, defenceShift, pattern.index, i, direction, pattern.miaiId, pattern.attackPriority, newMoves, journal);
                 }
             }
         }
-
-        if (updatedPatterns & FULL_PATTERN_MASK) {
-            break;
-        }
     }
 
-    _attackingMovesPriority[moveHash + blackPriorityShift] = blackPriority;
-    _attackingMovesPriority[moveHash + whitePriorityShift] = whitePriority;
+    setAttackPriority(moveHash + blackPriorityShift, blackPriority, journal);
+    setAttackPriority(moveHash + whitePriorityShift, whitePriority, journal);
 
     Debug::getInstance().stopTrack(DebugTimeTracks::UPDATE_TEMPLATES);
 }
 
-
-// TODO add node pruning
-//void AI::_partialPrune(MCTNode *node) {
-//    if (_nodesToPartialPrune <= 0) {
-//        return;
-//    }
-
-//    for (auto childrenIt = node->getChildren().begin(); childrenIt != node->getChildren().end();) {
-//        if ((*childrenIt)->getNodeVisits() < static_cast<unsigned>(_nodesToPartialPrune) || (*childrenIt)->getChildren().empty()) {
-//            auto nodeForDelete = (*childrenIt);
-//            childrenIt = node->getChildren().erase(childrenIt);
-
-//            _nodesToPartialPrune -= nodeForDelete->getNodeVisits();
-//            _nodesPruned += nodeForDelete->getNodeVisits();
-//            auto parent = nodeForDelete->getParent();
-//            while (parent) { parent->_nodeVisits -= nodeForDelete->getNodeVisits(); parent = parent->getParent(); }
-
-//            nodeForDelete->setParent(nullptr);
-//            delete nodeForDelete;
-//        } else {
-//            auto nodeToCheck = *childrenIt;
-//            ++childrenIt;
-//            _partialPrune(nodeToCheck);
-//        }
-//    }
-//}
-
-//bool AI::partialPrune(MCTNode* node) {
-//    _partialPrune(node);
-//    return node->getNodeVisits() == 0 || node->getChildren().empty();
-//}
-
-
-//void AI::update() {
-//    if (NODE_PRUNE_STRATEGY == NodePruneStrategy::SOFT && !_nodesToPrune.empty()) {
-//        _nodesToPartialPrune = NODE_VISIT_FOR_SAFE_DELETE;
-//        _nodesPruned = 0;
-
-//        auto node = _nodesToPrune.front();
-//        if (node->getNodeVisits() < NODE_VISIT_FOR_SAFE_DELETE || node->getChildren().empty()) {
-//            _nodesToPrune.pop_front();
-//            _nodesToPartialPrune -= node->getNodeVisits();
-//            _nodesPruned += node->getNodeVisits();
-//            node->setParent(nullptr);
-//            delete node;
-//        } else if (partialPrune(node)) {
-//            _nodesToPrune.pop_front();
-//            node->setParent(nullptr);
-//            delete  node;
-//        }
-//    }
+template class BasicBitField<15>;
+template class BasicBitField<19>;
+template class BasicBitField<LARGE_BOARD_SIZE>;
@@ -1,78 +1,180 @@
 #pragma once
 
 #include "common.h"
-#include <bitset>
-
-class BitField
+#include "moveset.h"
+#include "packedlines.h"
+#include "prioritybuckets.h"
+#include "widelines.h"
+#include <type_traits>
+
+// cells before and after a point its move patterns are matched on, see updateMovePriority
+constexpr short WINDOW_BEFORE_CELLS = 5;
+constexpr short WINDOW_GROUP_CELLS = 4;
+constexpr short WINDOW_AFTER_CELLS = WINDOW_GROUP_CELLS * 2;
+
+// one word per line while the pattern windows fit it, several words per player on wider boards
+template<short SIZE, size_t LINES_COUNT>
+using BoardLines = typename std::conditional<canPackLines(SIZE, WINDOW_BEFORE_CELLS + WINDOW_AFTER_CELLS + 1),
+    PackedLines<SIZE, LINES_COUNT>, WideLines<SIZE, LINES_COUNT>>::type;
+
+// Board of SIZE x SIZE cells, every line and table is sized at compile time
+template<short SIZE>
+class BasicBitField
 {
 public:
-    BitField();
+    using Geometry = BoardGeometry<SIZE>;
+    static constexpr short LENGTH = Geometry::LENGTH;
+
+    // x, y, color
+    using HistoryMove = std::array<short, 3>;
+    // room for getBestMoves to merge two priority buckets
+    using MovesBuffer = std::array<short, LENGTH * 2>;
+
+    // Old values of everything makeMove changed, lets unmakeMove restore the board exactly.
+    // It lives outside the board, so copying a board stays a plain memcpy.
+    class UndoJournal
+    {
+    public:
+        void clear() { _records.clear(); _frames.clear(); }
+        bool empty() const { return _frames.empty(); }
+    private:
+        friend class BasicBitField;
+
+        enum class UndoType : unsigned char {
+            AVAILABLE_MOVE_ADDED,
+            AVAILABLE_MOVE_REMOVED,
+            BUCKET_MOVE_REMOVED,
+            ATTACK_PRIORITY,
+            DEFENCE_PRIORITY,
+            DEFENCE_PATTERN_ADDED,
+            DEFENCE_PATTERN_REMOVED
+        };
+
+        struct UndoRecord {
+            UndoType type;
+            short key;
+            short index;
+            unsigned short value;
+        };
+
+        struct MoveFrame {
+            size_t journalSize;
+            int gameStatus;
+        };
+
+        std::vector<UndoRecord> _records;
+        // one per journaled move still on the board
+        std::vector<MoveFrame> _frames;
+    };
+
+    BasicBitField();
 
-    bool makeMove(short x, short y, short color);
-    bool unmakeMove();
+    // pass a journal to be able to take the move back
+    bool makeMove(short x, short y, short color, UndoJournal* journal = nullptr);
+    // restores every bit of state the last move made with the journal changed, down to the
+    // order of the available moves and the buckets
+    bool unmakeMove(UndoJournal& journal);
 
     short getRandomMove() const;
     short getMoveByPriority(short color) const;
     short getMovePriority(short hashedPosition, short color) const;
     short getMoveDefencePriority(short hashedPosition, short color) const;
-    std::vector<short> getBestMoves(short color) const;
+    // points into the board or into buffer, valid until the next change of either
+    Span<short> getBestMoves(short color, MovesBuffer& buffer) const;
+    // available moves by the priority of the pattern color makes there
+    const PriorityBuckets<LENGTH>& getAttackPriorities(short color) const { return _priorityBuckets[getAttackBucketsIndex(color)]; }
+    // available moves by the priority of the opponent's pattern they block
+    const PriorityBuckets<LENGTH>& getDefencePriorities(short color) const { return _priorityBuckets[getDefenceBucketsIndex(color)]; }
 
     int getGameStatus() const { return _gameStatus; }
-    const std::vector<short>& getAvailableMoves() const { return _availableMoves; }
-    const std::vector<std::tuple<short, short, short>>& getGameHistory() const { return _history; }
+    // Zobrist key of the stones on the board, 0 for the empty board
+    uint64_t getHash() const { return _hash; }
+    uint64_t computeHash() const;
+    Span<short> getAvailableMoves() const { return _availableMoves.getMoves(); }
+    Span<HistoryMove> getGameHistory() const { return {_history.data(), _historySize}; }
 
     void clear() {
-        _availableMovesHash.reset();
         _availableMoves.clear();
 
-        short fieldCenter = BOARD_SIZE / 2;
-        _availableMovesHash.set(getHashedPosition(fieldCenter, fieldCenter));
-        _availableMoves.push_back(getHashedPosition(fieldCenter, fieldCenter));
-
-        _horizontals.fill(0);
-        _verticals.fill(0);
-        _diagonal_right.fill(0);
-        _diagonal_left.fill(0);
+        _horizontals.clear();
+        _verticals.clear();
+        _diagonal_right.clear();
+        _diagonal_left.clear();
         _attackingMovesPriority.fill(0);
         _defensiveMovesPriority.fill({});
+        for (auto& buckets : _priorityBuckets) {
+            buckets.clear();
+        }
 
-        _filledHorizontals = 0;
-        _filledVerticals = 0;
-        _filledDiagonalsRight = 0;
-        _filledDiagonalsLeft = 0;
+        short fieldCenter = SIZE / 2;
+        insertAvailableMove(Geometry::getHashedPosition(fieldCenter, fieldCenter), 0);
 
-        _history.clear();
+        _historySize = 0;
 
+        _hash = 0;
         _gameStatus = 0;
     }
 
     static unsigned long getDiagonalRightIndex(short x, short y);
     static unsigned long getDiagonalLeftIndex(short x, short y);
 private:
-    void incrementalUpdate(short x, short y, short color);
-    void updateMovePriority(short x, short y, std::vector<short>& newMoves);
-    void createTemplate(short x, short y, short colorShift, short patternId, short attackId, short directionId, short miaiId, short priority, std::vector<short>& newMoves);
+    void incrementalUpdate(short x, short y, short color, UndoJournal* journal);
+    void updateMovePriority(short x, short y, std::vector<short>& newMoves, UndoJournal* journal);
+    void createTemplate(short x, short y, short colorShift, short patternId, short attackId, short directionId, short miaiId, short priority, std::vector<short>& newMoves, UndoJournal* journal);
+
+    static short getAttackBucketsIndex(short color) { return (color - 1) * 2; }
+    static short getDefenceBucketsIndex(short color) { return (color - 1) * 2 + 1; }
+
+    // keep the list, the set bits and the priority buckets of the available moves in step
+    void insertAvailableMove(short move, unsigned short index);
+    // returns the index the move had, inserting it back there restores the order of the list
+    unsigned short eraseAvailableMove(short move);
+    void writeAttackPriority(short key, unsigned char priority);
+    void writeDefencePriority(short key, unsigned short priority);
+
+    // unmakeMove puts moves back into the bucket slots they had, so the buckets are sampled
+    // the same after a move is taken back. The slot is 0 for a move that isn't available
+    short getBucketSlot(short bucketsIndex, short move) const;
+    unsigned short getBucketPriority(short bucketsIndex, short move) const;
+    void restoreAttackPriority(short key, unsigned char priority, short slot);
+    void restoreDefencePriority(short key, unsigned short priority, short slot);
+
+    // every change incrementalUpdate makes goes through these, so unmakeMove can revert it
+    void addAvailableMove(short move, UndoJournal* journal);
+    void removeAvailableMove(short move, UndoJournal* journal);
+    void setAttackPriority(short key, unsigned char priority, UndoJournal* journal);
+    void setDefencePriority(short key, unsigned short priority, UndoJournal* journal);
+    bool addDefencePattern(short key, unsigned short pattern, UndoJournal* journal);
+    void removeDefencePattern(short key, unsigned index, UndoJournal* journal);
 private:
-    std::bitset<BOARD_LENGTH> _availableMovesHash;
-    std::vector<short> _availableMoves;
+    MoveSet<LENGTH> _availableMoves;
+
+    // line i of the verticals is column x = i, bit y of a diagonal is the cell in row y
+    BoardLines<SIZE, SIZE> _horizontals;
+    BoardLines<SIZE, SIZE> _verticals;
+    BoardLines<SIZE, SIZE * 2> _diagonal_right;
+    BoardLines<SIZE, SIZE * 2> _diagonal_left;
 
-    std::array<unsigned long, BOARD_SIZE * 2> _horizontals = {0};
-    std::array<unsigned long, BOARD_SIZE * 2> _verticals = {0};
-    std::array<unsigned long, BOARD_SIZE * 2 * 2> _diagonal_right = {0};
-    std::array<unsigned long, BOARD_SIZE * 2 * 2> _diagonal_left = {0};
+    std::array<unsigned char, LENGTH * 2> _attackingMovesPriority = {0};
 
-    std::array<unsigned long, BOARD_LENGTH * 2> _attackingMovesPriority = {0};
+    // templates a cell defends against, one per line direction and miai id at most. Random games
+    // on every board size never put more than 13 on a cell (140k games). One that doesn't fit
+    // asserts in debug builds and leaves the cell priority alone, so removals stay in step
+    static constexpr unsigned DEFENCE_PATTERNS_CAPACITY = 16;
 
     struct DefensiveMove {
         unsigned short priority = 0;
-        std::vector<unsigned long> patterns;
+        unsigned short patternsCount = 0;
+        std::array<unsigned short, DEFENCE_PATTERNS_CAPACITY> patterns = {0};
 
-        void updatePriorityFast(unsigned short newPriority) {
-            priority = std::max(newPriority, priority);
-        }
+        const unsigned short* begin() const { return patterns.data(); }
+        const unsigned short* end() const { return patterns.data() + patternsCount; }
     };
 
-    std::array<DefensiveMove, BOARD_LENGTH * 2> _defensiveMovesPriority = {{}};
+    std::array<DefensiveMove, LENGTH * 2> _defensiveMovesPriority = {{}};
+
+    // available moves by attack and defence priority of both colors
+    std::array<PriorityBuckets<LENGTH>, 4> _priorityBuckets;
     /*
      * diagonal_right:
      *       *
@@ -87,13 +189,18 @@ private:
      *         *
      */
 
-    unsigned long _filledHorizontals = 0;
-    unsigned long _filledVerticals = 0;
-    unsigned long _filledDiagonalsRight = 0;
-    unsigned long _filledDiagonalsLeft = 0;
-
-    std::vector<std::tuple<short, short, short>> _history;
+    std::array<HistoryMove, LENGTH> _history = {{}};
+    unsigned short _historySize = 0;
 
+    uint64_t _hash = 0;
     int _gameStatus = 0;
 };
 
+// instantiated in bitfield.cpp
+extern template class BasicBitField<15>;
+extern template class BasicBitField<19>;
+extern template class BasicBitField<LARGE_BOARD_SIZE>;
+
+using BitField = BasicBitField<BOARD_SIZE>;
+
+static_assert(std::is_trivially_copyable<BitField>::value, "search snapshots copy boards with memcpy");
@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <unordered_set>
 #include <unordered_map>
 
@@ -17,9 +19,14 @@ static constexpr short BLACK_PIECE_COLOR = 1;
 static constexpr short WHITE_PIECE_COLOR = 2;
 static constexpr short FIRST_MOVE_COLOR = BLACK_PIECE_COLOR;
 static constexpr short MOVES_IN_ROW_TO_WIN = 5;
+// board of the large-board analysis, wider than a line packed into one word
+static constexpr short LARGE_BOARD_SIZE = 41;
+// largest board the engine is built for, Zobrist keys and node blocks are sized for it
+static constexpr short MAX_BOARD_SIZE = LARGE_BOARD_SIZE;
+static constexpr short MAX_BOARD_LENGTH = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+// board of the app and of the BitField and MCTSTree aliases
 static constexpr short BOARD_SIZE = 19;
 static constexpr short BOARD_LENGTH = BOARD_SIZE * BOARD_SIZE;
-static constexpr unsigned long FILLED_ROW_BITS = (1 << BOARD_SIZE) - 1;
 static constexpr std::array<unsigned, 9> FFS_TABLE = {0, 1, 2, 0, 3, 0, 0, 0, 4};
 
 inline static constexpr short extractPositionX(unsigned long userData) {
@@ -46,16 +53,30 @@ inline static constexpr unsigned long writeColorData(short color, unsigned long
     return (userData & (~(DATA_MOVE_MASK << COLOR_DATA_MASK_SIZE))) | (color << COLOR_DATA_MASK_SIZE);
 }
 
+// Cell indexing of an N x N board, cells are hashed row by row.
+template<short N>
+struct BoardGeometry
+{
+    static_assert(N >= MOVES_IN_ROW_TO_WIN && N <= MAX_BOARD_SIZE, "unsupported board size");
+
+    static constexpr short SIZE = N;
+    static constexpr short LENGTH = N * N;
+
+    static constexpr short getHashedPosition(short x, short y) { return x + y * N; }
+    static constexpr short extractX(unsigned position) { return position % N; }
+    static constexpr short extractY(unsigned position) { return position / N; }
+};
+
 inline static constexpr short getHashedPosition(short x, short y) {
-    return x + y * BOARD_SIZE;
+    return BoardGeometry<BOARD_SIZE>::getHashedPosition(x, y);
 }
 
 inline static constexpr short extractHashedPositionX(unsigned pos) {
-    return pos % BOARD_SIZE;
+    return BoardGeometry<BOARD_SIZE>::extractX(pos);
 }
 
 inline static constexpr short extractHashedPositionY(unsigned pos) {
-    return pos / BOARD_SIZE;
+    return BoardGeometry<BOARD_SIZE>::extractY(pos);
 }
 
 inline static constexpr short getNextPlayerColor(short color) {
@@ -66,55 +87,48 @@ inline static constexpr short getNextPlayerColor(short color) {
     return color == BLACK_PIECE_COLOR ? WHITE_PIECE_COLOR : BLACK_PIECE_COLOR;
 }
 
-static std::array<short, BOARD_LENGTH> distanceToLeftEdge() {
-    std::array<short, BOARD_LENGTH> result;
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            result[getHashedPosition(x, y)] = BOARD_SIZE - x - 1;
-        }
-    }
-
-    return result;
-}
-
-static std::array<short, BOARD_LENGTH> distanceToRightEdge() {
-    std::array<short, BOARD_LENGTH> result;
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            result[getHashedPosition(x, y)] = x;
-        }
-    }
-
-    return result;
-}
+// Read-only view of a contiguous range, exposes fixed size storage without copying it.
+template <typename T>
+class Span
+{
+public:
+    Span(const T* data, size_t size) : _data(data), _size(size) {}
+
+    const T* begin() const { return _data; }
+    const T* end() const { return _data + _size; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    const T& operator[](size_t index) const { return _data[index]; }
+    const T& front() const { return _data[0]; }
+    const T& back() const { return _data[_size - 1]; }
+private:
+    const T* _data;
+    size_t _size;
+};
 
-static std::array<short, BOARD_LENGTH> distanceToTopEdge() {
-    std::array<short, BOARD_LENGTH> result;
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            result[getHashedPosition(x, y)] = BOARD_SIZE - y - 1;
-        }
+// splitmix64 sequence, the keys are the same in every build so hashes can be stored on disk
+static constexpr std::array<uint64_t, MAX_BOARD_LENGTH * 2> generateZobristKeys() {
+    std::array<uint64_t, MAX_BOARD_LENGTH * 2> result = {0};
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (auto& key : result) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        key = z ^ (z >> 31);
     }
 
     return result;
 }
 
-static std::array<short, BOARD_LENGTH> distanceToBottomEdge() {
-    std::array<short, BOARD_LENGTH> result;
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            result[getHashedPosition(x, y)] = y;
-        }
-    }
+static constexpr std::array<uint64_t, MAX_BOARD_LENGTH * 2> ZOBRIST_KEYS = generateZobristKeys();
 
-    return result;
+// smaller boards use a part of the keys, positions of one board size never share a key
+inline static constexpr uint64_t getZobristKey(short hashedPosition, short color) {
+    return ZOBRIST_KEYS[hashedPosition + (color - 1) * MAX_BOARD_LENGTH];
 }
 
-static const std::array<short, BOARD_LENGTH> BOARD_DISTANCE_RIGHT = distanceToRightEdge();
-static const std::array<short, BOARD_LENGTH> BOARD_DISTANCE_LEFT = distanceToLeftEdge();
-static const std::array<short, BOARD_LENGTH> BOARD_DISTANCE_TOP = distanceToTopEdge();
-static const std::array<short, BOARD_LENGTH> BOARD_DISTANCE_BOTTOM = distanceToBottomEdge();
-
 struct AIMoveData {
     short position = 0;
     short x = 0;
@@ -126,6 +140,10 @@ struct AIMoveData {
 
     unsigned nodeVisits = 0;
     unsigned moveIndex = 0;
+    // 1 the move is proven to win, -1 to lose
+    short proof = 0;
+    // the searcher ranks moves by score and plays this one, nodeVisits only tell the effort
+    bool isChosen = false;
 };
 
 static constexpr short AI_PATTERN_DEFENCES_COUNT = 4;
@@ -146,54 +164,12 @@ struct AIPattern {
     std::array<short, AI_PATTERN_DEFENCES_COUNT> defencePriorities = {0};
 };
 
-static constexpr unsigned PATTERNS_COUNT = 35;
-static constexpr std::array<AIPattern, PATTERNS_COUNT> generatePatterns() {
-//    short id = 0;
-    std::array<AIPattern, PATTERNS_COUNT> result = {{
-                                                        {0, 15, 1, 0, -4, 0, 0, 8, 1, {0}, {8}},
-                                                        {1, 23, 1, 0, -3, 0, 0, 8, 2, {0}, {8}},
-                                                        {2, 27, 1, 0, -2, 0, 0, 8, 3, {0}, {8}},
-                                                        {3, 29, 1, 0, -1, 0, 0, 8, 4, {0}, {8}},
-                                                        {4, 15, 1, 0, 1, 0, 0, 8, 5, {0}, {8}},
-                                                        {5, 7, 35, 0, 1, -1, 0, 6, 6, {0, 4}, {6, 6}},
-                                                        {6, 7, 49, 0, -3, -4, 0, 6, 6, {0, -4}, {6, 6}},
-                                                        {7, 13, 37, 0, -1, -2, 0, 6, 7, {0, 3, -2}, {6, 6, 6}},
-                                                        {8, 11, 41, 0, -2, -3, 0, 6, 8, {0, 2, -3}, {6, 6, 6}},
-                                                        {9, 19, 3, 0, -2, 1, 0, 4, 16, {0, 1}, {4, 4}},
-                                                        {10, 19, 3, 0, -3, -1, 0, 4, 16, {0, -1}, {4, 4}},
-                                                        {11, 25, 3, 0, -2, -1, 0, 4, 17, {0, -1}, {4, 4}},
-                                                        {12, 25, 3, 0, -1, 1, 0, 4, 17, {0, 1}, {4, 4}},
-                                                        {13, 11, 41, 0, -4, -5, 0, 4, 7, {0, -2, -5}, {4, 4, 4}},
-                                                        {14, 11, 41, 0, 1, 3, 0, 4, 7, {0, 3, 5}, {4, 4, 4}},
-                                                        {15, 13, 37, 0, -4, -5, 0, 4, 8, {0, -3, -5}, {4, 4, 4}},
-                                                        {16, 13, 37, 0, 1, 2, 0, 4, 8, {0, 2, 5}, {4, 4, 4}},
-                                                        {17, 13, 5, 1, -1, -2, 3, 4, 9, {0, -2}, {4, 4}},
-                                                        {18, 13, 5, 1, 1, 2, 5, 4, 9, {0, 2}, {4, 4}},
-                                                        {19, 13, 9, 1, -1, 3, -2, 4, 10, {0, 3}, {4, 4}},
-                                                        {20, 13, 9, 1, -4, -3, -5, 4, 10, {0, -3}, {4, 4}},
-                                                        {21, 11, 9, 1, -2, -3, 2, 4, 11, {0, -3}, {4, 4}},
-                                                        {22, 11, 9, 1, 1, 3, 5, 4, 11, {0, 3}, {4, 4}},
-                                                        {23, 11, 5, 1, -2, 2, -3, 4, 12, {0, 2}, {4, 4}},
-                                                        {24, 11, 5, 1, -4, -2, -5, 4, 12, {0, -2}, {4, 4}},
-                                                        {25, 7, 3, 1, 1, -1, 4, 4, 13, {0, -1}, {4, 4}},
-                                                        {26, 7, 3, 1, 2, 1, 5, 4, 13, {0, 1}, {4, 4}},
-                                                        {27, 7, 3, 1, -3, 1, -4, 4, 14, {0, 1}, {4, 4}},
-                                                        {28, 7, 3, 1, -4, -1, -5, 4, 14, {0, -1}, {4, 4}},
-                                                        {29, 7, 17, 65, -3, -4, -5, 4, 15, {0, -4}, {4, 4}},
-                                                        {30, 7, 17, 65, 1, 4, -1, 4, 15, {0, 4}, {4, 4}},
-                                                        {31, 3, 39, 0, 2, -1, 0, 2, 18, {0, 1, 4}, {2, 2, 2}},
-                                                        {32, 3, 39, 0, 1, -2, 0, 2, 18, {0, 3, -1}, {2, 2, 2}},
-                                                        {33, 3, 57, 0, -3, -4, 0, 2, 18, {0, -1, -4}, {2, 2, 2}},
-                                                        {34, 3, 57, 0, -2, -3, 0, 2, 18, {0, 1, -3}, {2, 2, 2}},
-    }};
-
-    return result;
-}
+// MOVE_PATTERNS are generated from Templates.json into movepatterns.h at build time
 
 struct MOVE_PRIORITIES {
     static constexpr short IMMIDIATE = 8;
     static constexpr short URGENT = 6;
     static constexpr short HIGH = 4;
+    // makes an open three
+    static constexpr short MEDIUM = 2;
 };
-
-static constexpr std::array<AIPattern, PATTERNS_COUNT> MOVE_PATTERNS = generatePatterns();
@@ -1,22 +1,26 @@
 #include "debug.h"
-#include <QDebug>
+#include <iostream>
 
 
 Debug::Debug() {
 
 }
 
+int64_t Debug::nsecsElapsed() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _timerStart).count();
+}
+
 void Debug::startTrack(DebugTimeTracks track) {
     if (!_isEnabled) {
         return;
     }
 
-    if (!_timer) {
-        _timer = new QElapsedTimer();
-        _timer->start();
+    if (!_isTimerStarted) {
+        _timerStart = std::chrono::steady_clock::now();
+        _isTimerStarted = true;
     }
 
-    _tracksStart[static_cast<int>(track)] = _timer->nsecsElapsed();
+    _tracksStart[static_cast<int>(track)] = nsecsElapsed();
 }
 
 void Debug::stopTrack(DebugTimeTracks track) {
@@ -24,7 +28,7 @@ void Debug::stopTrack(DebugTimeTracks track) {
         return;
     }
 
-    _tracksEnd[static_cast<int>(track)] = _timer->nsecsElapsed();
+    _tracksEnd[static_cast<int>(track)] = nsecsElapsed();
 
     _tracksTime[static_cast<int>(track)] += (_tracksEnd[static_cast<int>(track)] - _tracksStart[static_cast<int>(track)]);
     _trackedTimeTracks[static_cast<int>(track)] = true;
@@ -52,12 +56,8 @@ void Debug::resetStats() {
     for (unsigned i = 0; i < TRACKS_COUNT; ++i) _trackedTimeTracks[i] = false;
     for (unsigned i = 0; i < TRACKS_COUNT; ++i) _trackedCallTracks[i] = false;
 
-    if (_timer) {
-        _timer->restart();
-    } else {
-        _timer = new QElapsedTimer();
-        _timer->start();
-    }
+    _timerStart = std::chrono::steady_clock::now();
+    _isTimerStarted = true;
 }
 
 void Debug::printStats(DebugTrackLevel level) {
@@ -65,7 +65,7 @@ void Debug::printStats(DebugTrackLevel level) {
         return;
     }
 
-    qDebug() << "Time tracks:";
+    std::cout << "Time tracks:" << std::endl;
     for (unsigned i = 0; i < static_cast<unsigned>(DebugTimeTracks::TOTAL_TRACKS); ++i) {
         if (!_trackedTimeTracks[i]) {
             continue;
@@ -73,9 +73,9 @@ void Debug::printStats(DebugTrackLevel level) {
         if (_timeTracksDebugLevel[i] < static_cast<unsigned>(level)) {
             continue;
         }
-        qDebug() << _timeTrackNames[i].c_str() << " time: " << _tracksTime[i];
+        std::cout << _timeTrackNames[i] << " time: " << _tracksTime[i] << std::endl;
     }
-    qDebug() << "Call tracks:";
+    std::cout << "Call tracks:" << std::endl;
     for (unsigned i = 0; i < static_cast<unsigned>(DebugCallTracks::TOTAL_TRACKS); ++i) {
         if (!_trackedCallTracks[i]) {
             continue;
@@ -83,6 +83,6 @@ void Debug::printStats(DebugTrackLevel level) {
         if (_callTracksDebugLevel[i] < static_cast<unsigned>(level)) {
             continue;
         }
-        qDebug() << _callTrackNames[i].c_str() << ": " << _callTracks[i];
+        std::cout << _callTrackNames[i] << ": " << _callTracks[i] << std::endl;
     }
 }
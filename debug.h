@@ -1,8 +1,9 @@
 #pragma once
 
 #include <array>
-#include <QtGlobal>
-#include <QElapsedTimer>
+#include <chrono>
+#include <cstdint>
+#include <string>
 
 
 enum class DebugTrackLevel : unsigned {
@@ -46,12 +47,7 @@ public:
     }
 
     Debug();
-    virtual ~Debug() {
-        if (_timer) {
-            delete _timer;
-            _timer = nullptr;
-        }
-    }
+    virtual ~Debug() = default;
 
     void registerTimeTrackName(DebugTimeTracks track, std::string trackName) { _timeTrackNames[static_cast<unsigned>(track)] = trackName; }
     void registerCallTrackName(DebugCallTracks track, std::string trackName) { _callTrackNames[static_cast<unsigned>(track)] = trackName; }
@@ -66,17 +62,19 @@ public:
     void resetStats();
     void printStats(DebugTrackLevel);
 
-    qint64 getTrackStats(DebugTimeTracks track) const { return _tracksTime[static_cast<unsigned>(track)]; }
-    qint64 getCallStats(DebugCallTracks track) const { return _callTracks[static_cast<unsigned>(track)]; }
+    int64_t getTrackStats(DebugTimeTracks track) const { return _tracksTime[static_cast<unsigned>(track)]; }
+    int64_t getCallStats(DebugCallTracks track) const { return _callTracks[static_cast<unsigned>(track)]; }
 
 
 private:
+    int64_t nsecsElapsed() const;
+
     static constexpr unsigned TRACKS_COUNT = 32;
 
-    std::array<qint64, TRACKS_COUNT> _tracksStart;
-    std::array<qint64, TRACKS_COUNT> _tracksEnd;
-    std::array<qint64, TRACKS_COUNT> _tracksTime;
-    std::array<qint64, TRACKS_COUNT> _callTracks;
+    std::array<int64_t, TRACKS_COUNT> _tracksStart;
+    std::array<int64_t, TRACKS_COUNT> _tracksEnd;
+    std::array<int64_t, TRACKS_COUNT> _tracksTime;
+    std::array<int64_t, TRACKS_COUNT> _callTracks;
 
     std::array<bool, TRACKS_COUNT> _trackedTimeTracks;
     std::array<bool, TRACKS_COUNT> _trackedCallTracks;
@@ -87,6 +85,7 @@ private:
     std::array<unsigned, TRACKS_COUNT> _timeTracksDebugLevel;
     std::array<unsigned, TRACKS_COUNT> _callTracksDebugLevel;
 
-    QElapsedTimer* _timer = nullptr;
+    std::chrono::steady_clock::time_point _timerStart;
+    bool _isTimerStarted = false;
     bool _isEnabled = false;
 };
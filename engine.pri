@@ -0,0 +1,57 @@
+# Search engine sources shared by the Qt app and the headless targets.
+# Nothing listed here may depend on Qt.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# engine consistency asserts (e.g. the Zobrist recompute) only run in debug builds
+CONFIG(release, debug|release): DEFINES += NDEBUG
+
+# "qmake CONFIG+=engine_avx2" looks the patterns of all four lines up at once,
+# the default build keeps the scalar path that runs on any CPU
+engine_avx2: QMAKE_CXXFLAGS += -mavx2
+# "CONFIG+=engine_bmi2" cuts the pattern windows out of the lines with pext, which is slow before Zen 3 on AMD
+engine_bmi2: QMAKE_CXXFLAGS += -mbmi2
+
+# MOVE_PATTERNS are generated from Templates.json, so editing a template only takes a rebuild
+PATTERN_TEMPLATES = $$PWD/Templates.json
+movepatterns.input = PATTERN_TEMPLATES
+movepatterns.output = $$OUT_PWD/movepatterns.h
+movepatterns.commands = python3 $$PWD/TemplatesGenerator.py ${QMAKE_FILE_IN} ${QMAKE_FILE_OUT}
+movepatterns.depends = $$PWD/TemplatesGenerator.py
+movepatterns.variable_out = HEADERS
+movepatterns.CONFIG += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += movepatterns
+INCLUDEPATH += $$OUT_PWD
+
+SOURCES += \
+    $$PWD/alphabetasearch.cpp \
+    $$PWD/bitfield.cpp \
+    $$PWD/debug.cpp \
+    $$PWD/mctsnode.cpp \
+    $$PWD/mctstree.cpp \
+    $$PWD/nodearena.cpp \
+    $$PWD/searchthread.cpp \
+    $$PWD/threadpool.cpp \
+    $$PWD/threatsearch.cpp \
+    $$PWD/timemanager.cpp \
+    $$PWD/transpositiontable.cpp
+
+HEADERS += \
+    $$PWD/common.h \
+    $$PWD/alphabetasearch.h \
+    $$PWD/bitfield.h \
+    $$PWD/debug.h \
+    $$PWD/mctsnode.h \
+    $$PWD/mctstree.h \
+    $$PWD/moveset.h \
+    $$PWD/nodearena.h \
+    $$PWD/packedlines.h \
+    $$PWD/prioritybuckets.h \
+    $$PWD/searcher.h \
+    $$PWD/searchthread.h \
+    $$PWD/threadpool.h \
+    $$PWD/threatsearch.h \
+    $$PWD/timemanager.h \
+    $$PWD/transpositiontable.h \
+    $$PWD/widelines.h
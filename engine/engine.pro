@@ -0,0 +1,7 @@
+TEMPLATE = lib
+TARGET = gomokuengine
+
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+include(../engine.pri)
@@ -0,0 +1,10 @@
+# Headless build: the engine as a static library plus the benchmark CLI.
+# Use MCTSGomoku.pro for the Qt application.
+
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    engine \
+    bench
+
+bench.depends = engine
@@ -4,6 +4,8 @@
 #include "common.h"
 #include "bitfield.h"
 #include "mctstree.h"
+#include "searchthread.h"
+#include "timemanager.h"
 #include <QMessageBox>
 #include <QTimer>
 #include <QDebug>
@@ -42,17 +44,14 @@ MainWindow::MainWindow(QWidget *parent)
     ui->aiLevel->addItem("Level 9");
     ui->aiLevel->addItem("Level 10");
 
-    QTimer *timer = new QTimer(this);
-    connect(timer, SIGNAL(timeout()), this, SLOT(updateAI()));
-    timer->start(16);
-
     QTimer *timer2 = new QTimer(this);
     connect(timer2, SIGNAL(timeout()), this, SLOT(updateAIField()));
     timer2->start(2000);
 
     QTimer *aiMoveTimer = new QTimer(this);
     connect(aiMoveTimer, SIGNAL(timeout()), this, SLOT(checkAIMove()));
-    aiMoveTimer->start(5000);
+    // only reads a flag, the time manager decides when the move is ready
+    aiMoveTimer->start(20);
 
 
     Debug::getInstance().registerTimeTrackName(DebugTimeTracks::GAME_UPDATE, "Update Game");
@@ -79,69 +78,20 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    delete _searchThread;
+    delete _mctsTree;
+    delete _timeManager;
     delete ui;
     delete _fieldView;
 }
 
-void MainWindow::updateAI() {
-    if(!_isGameStarted) {
-        return;
-    }
-
-    if (_currentMode == MODE::VIEW_TREE || _currentMode == MODE::MANUAL_AI_DEBUG) {
-        return;
-    }
-
-    if (!_mctsTree) {
-        return;
-    }
-
-    Debug::getInstance().resetStats();
-    Debug::getInstance().startTrack(DebugTimeTracks::GAME_UPDATE);
-
-    _aiBudget += 16 * 1000000;
-    if (_aiBudget <= 0) {
-        if (_aiBudget < 15 * 1000000) {
-            _aiBudget = 0;
-        }
-        return;
-    }
-    qint64 currentUpdateTime = 0;
-    unsigned updatesCount = 0;
-    QElapsedTimer updateTimer;
-    updateTimer.start();
-
-    do {
-        qint64 updateStartTime = updateTimer.nsecsElapsed();
-
-        _mctsTree->update(_bitField);
-
-        Debug::getInstance().trackCall(DebugCallTracks::GAME_UPDATE);
-
-        _totalAiGames += 1;
-        _currentAiGames += _mctsTree->getThreadsCount();
-        updatesCount++;
-
-        currentUpdateTime = updateTimer.nsecsElapsed() - updateStartTime;
-        _aiBudget -= currentUpdateTime;
-    } while (_aiBudget > currentUpdateTime);
-
-//    qint64 totalUpdateTime = updateTimer.nsecsElapsed();
-//    qDebug() << _aiBudget << currentUpdateTime << totalUpdateTime;
-
-    Debug::getInstance().stopTrack(DebugTimeTracks::GAME_UPDATE);
-    Debug::getInstance().printStats(DebugTrackLevel::DEBUG);
-
-    ui->aiTotalGames->setText(QString::number(MCTSNode::MAX_DEPTH));
-    ui->aiCurrentGames->setText(QString::number(_currentAiGames));
-}
-
 void MainWindow::updateAIOnce() {
     if(!_isGameStarted) {
         return;
     }
 
     if (_mctsTree) {
+        _searchThread->stop();
         MCTSTree::NODE_EXPLORATIONS_TO_EXPAND = 1;
         _mctsTree->update(_bitField);
     }
@@ -156,7 +106,27 @@ void MainWindow::updateAIOnce() {
 }
 
 void MainWindow::updateAIField() {
+    if (_searchThread) {
+        _searchThread->stop();
+        _totalAiGames += _searchThread->getUpdatesCount();
+    }
     updateField();
+    resumeSearch();
+}
+
+void MainWindow::resumeSearch() {
+    if (!_searchThread || !_isGameStarted || _currentMode == MODE::VIEW_TREE || _currentMode == MODE::MANUAL_AI_DEBUG) {
+        return;
+    }
+
+    if (getCurrentColor() == _aiPlayerColor) {
+        if (!_timeManager->isMoveStarted()) {
+            _timeManager->startMove(_mctsTree->getNodesData());
+        }
+        _searchThread->start(*_bitField, _timeManager);
+    } else {
+        _searchThread->ponder(*_bitField);
+    }
 }
 
 void MainWindow::checkAIMove() {
@@ -164,23 +134,17 @@ void MainWindow::checkAIMove() {
         return;
     }
 
-    if (getCurrentColor() != _aiPlayerColor) {
+    if (getCurrentColor() != _aiPlayerColor || !_mctsTree || !_searchThread->isFinished()) {
         return;
     }
 
-    if (_mctsTree && (_mctsTree->getTotalPlayouts() > (_mctsTree->getChildrenCount() * 1000 * _aiLevel * _aiLevel) || _mctsTree->getChildrenCount() == 1)) {
-        auto nodesData = _mctsTree->getNodesData();
-        float bestScores = -100.f;
-        short bestPosition = -1;
-
-        for (auto& node : nodesData) {
-            if (node.scores > bestScores) {
-                bestScores = node.scores;
-                bestPosition = node.position;
-            }
-        }
-        makeMove(extractHashedPositionX(bestPosition), extractHashedPositionY(bestPosition));
+    _searchThread->stop();
+    short bestPosition = TimeManager::getBestMove(_mctsTree->getNodesData());
+    if (bestPosition < 0) {
+        resumeSearch();
+        return;
     }
+    makeMove(extractHashedPositionX(bestPosition), extractHashedPositionY(bestPosition));
 }
 
 void MainWindow::updateField() {
@@ -192,6 +156,7 @@ void MainWindow::updateField() {
     }
 
     if (_mctsTree) {
+        _currentAiGames = _mctsTree->getTotalPlayouts();
         if (_showBestPlayout) {
             auto aiMoves = _mctsTree->getBestPlayout(_bestPlayoutX, _bestPlayoutY);
             for (auto& aiMove : aiMoves) {
@@ -285,7 +250,7 @@ void MainWindow::onFieldClick(short x, short y, Qt::MouseButton button) {
 //            }
 //        }
 
-        updateField();
+        updateAIField();
         return;
     }
 
@@ -294,14 +259,14 @@ void MainWindow::onFieldClick(short x, short y, Qt::MouseButton button) {
             _showBestPlayout = false;
             _bestPlayoutX = -1;
             _bestPlayoutY = -1;
-            updateField();
+            updateAIField();
             return;
         }
 
         _bestPlayoutX = cellX;
         _bestPlayoutY = cellY;
         _showBestPlayout = true;
-        updateField();
+        updateAIField();
 
         return;
     }
@@ -321,15 +286,22 @@ void MainWindow::onFieldClick(short x, short y, Qt::MouseButton button) {
 
 void MainWindow::makeMove(short x, short y) {
     qDebug() << "{" << x << "," << y << "}";
+    if (_searchThread) {
+        _searchThread->stop();
+    }
+
     if (!_bitField->makeMove(x, y, getCurrentColor())) {
+        resumeSearch();
         return;
     }
 
     if (_mctsTree) {
         _mctsTree->selectChild(x, y);
     }
+    if (_timeManager && getCurrentColor() == _aiPlayerColor) {
+        _timeManager->finishMove();
+    }
 
-    _currentAiGames = 0;
     _currentPlayer = getNextPlayerColor(_currentPlayer);
 
     updateField();
@@ -350,6 +322,8 @@ void MainWindow::makeMove(short x, short y) {
 
         return;
     }
+
+    resumeSearch();
 }
 
 void MainWindow::checkPattern() {
@@ -415,7 +389,7 @@ void MainWindow::onlyWhiteModeClick() {
 void MainWindow::showAIPlayouts() {
     _showPlayouts = ui->showPlayouts->isChecked();
 
-    updateField();
+    updateAIField();
 }
 
 void MainWindow::onNewGameStarted() {
@@ -426,12 +400,20 @@ void MainWindow::onNewGameStarted() {
     _aiLevel = ui->aiLevel->currentIndex() + 1;
 
     if (_mctsTree) {
-        delete _mctsTree;
-        _mctsTree = nullptr;
+        _searchThread->stop();
+        _mctsTree->reset(_aiPlayerColor);
+    } else {
+        _mctsTree = new MCTSTree(_aiPlayerColor);
+        _searchThread = new SearchThread(*_mctsTree);
+        _timeManager = new TimeManager();
     }
-    _mctsTree = new MCTSTree(_aiPlayerColor);
+
+    TimeManager::Limits limits;
+    limits.moveTimeMs = AI_LEVEL_MOVE_TIME_MS * _aiLevel;
+    _timeManager->setLimits(limits);
 
     updateField();
+    resumeSearch();
 
 //    _testMoves = {
 //        { 7 , 8 },
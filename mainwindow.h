@@ -2,14 +2,20 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include "common.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
 class FieldWidget;
-class BitField;
-class MCTSTree;
+class TimeManager;
+template<short SIZE> class BasicBitField;
+template<short SIZE> class BasicMCTSTree;
+template<short SIZE> class BasicSearchThread;
+using BitField = BasicBitField<BOARD_SIZE>;
+using MCTSTree = BasicMCTSTree<BOARD_SIZE>;
+using SearchThread = BasicSearchThread<BOARD_SIZE>;
 
 class MainWindow : public QMainWindow
 {
@@ -21,7 +27,6 @@ public:
 public slots:
     void onNewGameStarted();
     void checkPattern();
-    void updateAI();
     void updateAIField();
     void updateAIOnce();
     void checkAIMove();
@@ -32,7 +37,10 @@ public slots:
     void showAIPlayouts();
 private:
     void onFieldClick(short x, short y, Qt::MouseButton button);
+    // reads the tree, so the search has to be stopped
     void updateField();
+    // searches on the AI's turn and ponders on the human's
+    void resumeSearch();
 
     void makeMove(short x, short y);
 
@@ -57,6 +65,8 @@ private:
 
     BitField* _bitField = nullptr;
     MCTSTree* _mctsTree = nullptr;
+    SearchThread* _searchThread = nullptr;
+    TimeManager* _timeManager = nullptr;
 
     bool _isGameStarted = false;
     short _currentPlayer = -1;
@@ -64,12 +74,12 @@ private:
 
     short _forcedColor = -1;
 
+    // every AI level adds that much thinking time per move
+    static constexpr int64_t AI_LEVEL_MOVE_TIME_MS = 1000;
     unsigned _aiLevel = 1;
     unsigned _totalAiGames = 0;
     unsigned _currentAiGames = 0;
 
-    qint64 _aiBudget = 0;
-
     std::vector<std::pair<short, short>> _testMoves;
 };
 #endif // MAINWINDOW_H
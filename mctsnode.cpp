@@ -1,21 +1,61 @@
 #include "mctsnode.h"
 
-long MCTSNode::NODES_CREATED = 0;
-short MCTSNode::MAX_DEPTH = 0;
+std::atomic<long> MCTSNode::NODES_CREATED = {0};
+std::atomic<short> MCTSNode::MAX_DEPTH = {0};
 
 MCTSNode::MCTSNode()
 {
-    NODES_CREATED++;
+    NODES_CREATED.fetch_add(1, std::memory_order_relaxed);
 }
 
+void MCTSNode::publishChildren(MCTSNode* children, unsigned short count) {
+    if (count == 0) {
+        return;
+    }
 
-void MCTSNode::addChild(MCTSNode* child) {
-    child->_next = _head;
-    child->_parent = this;
-    _head = child;
+    _childrenCount = count;
+    _children.store(children, std::memory_order_release);
+}
+
+bool MCTSNode::updateProof(unsigned winPriorPlayouts) {
+    if (isProven()) {
+        return true;
+    }
+
+    MCTSNode* children = getChildren();
+    if (!children) {
+        return false;
+    }
+
+    // one winning reply refutes the move, it only wins when every reply loses
+    bool allRepliesLose = true;
+    for (unsigned short i = 0; i < _childrenCount; ++i) {
+        if (children[i].isProvenWin()) {
+            setProvenLoss();
+            return true;
+        }
+        allRepliesLose = allRepliesLose && children[i].isProvenLoss();
+    }
 
-    child->__depth = __depth + 1;
-    MAX_DEPTH = child->__depth > MAX_DEPTH ? __depth + 1 : MAX_DEPTH;
+    if (!allRepliesLose) {
+        return false;
+    }
+
+    if (areRepliesComplete()) {
+        setProvenWin();
+        return true;
+    }
+
+    // scores are kept for the mover of the node
+    if (!(_flags.fetch_or(WIN_PRIOR_FLAG, std::memory_order_relaxed) & WIN_PRIOR_FLAG)) {
+        addPlayouts(winPriorPlayouts);
+        addScore(winPriorPlayouts);
+    }
+
+    return false;
+}
 
-    this->_childrenCount++;
+void MCTSNode::updateMaxDepth(short depth) {
+    short maxDepth = MAX_DEPTH.load(std::memory_order_relaxed);
+    while (depth > maxDepth && !MAX_DEPTH.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {}
 }
@@ -1,62 +1,96 @@
 #ifndef MCTSNODE_H
 #define MCTSNODE_H
 
+#include <atomic>
 
+// 32 byte node. The stats every selection pass reads for each child come first, children
+// live in one contiguous block owned by the parent, so selection is a linear scan.
+// There is no parent link: explore() backs results up along the path it descended.
 class MCTSNode
 {
 public:
-    static long NODES_CREATED;
-    static short MAX_DEPTH;
+    static std::atomic<long> NODES_CREATED;
+    static std::atomic<short> MAX_DEPTH;
 
-    MCTSNode();
-
-    bool isLeaf() const { return _head == nullptr; }
-
-    unsigned getPlayouts() const { return _playouts; }
-    void setPlayouts(unsigned value) { _playouts = value; }
-    void addPlayout() { _playouts++; }
-
-    unsigned getRealPlayouts() const { return _realPlayouts; }
-    void addRealPlayouts(unsigned value) { _realPlayouts += value; }
-
-    float getScore() const { return _score; }
-    void setScore(float value) { _score = value; }
-    void addScore(float value) { _score += value; }
-
-    bool isTerminal() const { return _isTerminal; }
-    void setTerminal() { _isTerminal = true; }
-
-    MCTSNode* getParent() const { return _parent; }
-    void setParent(MCTSNode* parent) { _parent = parent; }
+    // score a pending visit counts with while a worker is still below the node
+    static constexpr float VIRTUAL_LOSS = 1.f;
 
-    MCTSNode* getChildHead() const { return _head; }
-    MCTSNode* getNextNode() const { return _next; }
-
-    void addChild(MCTSNode* child);
+    MCTSNode();
 
-    short getChildrenCount() const { return _childrenCount; }
+    bool isLeaf() const { return _children.load(std::memory_order_acquire) == nullptr; }
+
+    unsigned getPlayouts() const { return _playouts.load(std::memory_order_relaxed); }
+    void setPlayouts(unsigned value) { _playouts.store(value, std::memory_order_relaxed); }
+    void addPlayout() { _playouts.fetch_add(1, std::memory_order_relaxed); }
+    void addPlayouts(unsigned value) { _playouts.fetch_add(value, std::memory_order_relaxed); }
+
+    unsigned getRealPlayouts() const { return _realPlayouts.load(std::memory_order_relaxed); }
+    void addRealPlayouts(unsigned value) { _realPlayouts.fetch_add(value, std::memory_order_relaxed); }
+
+    float getScore() const { return _score.load(std::memory_order_relaxed); }
+    void setScore(float value) { _score.store(value, std::memory_order_relaxed); }
+    void addScore(float value) {
+        float score = _score.load(std::memory_order_relaxed);
+        while (!_score.compare_exchange_weak(score, score + value, std::memory_order_relaxed)) {}
+    }
+
+    unsigned getVirtualLoss() const { return _virtualLoss.load(std::memory_order_relaxed); }
+    void addVirtualLoss() { _virtualLoss.fetch_add(1, std::memory_order_relaxed); }
+    void removeVirtualLoss() { _virtualLoss.fetch_sub(1, std::memory_order_relaxed); }
+
+    bool isTerminal() const { return _flags.load(std::memory_order_relaxed) & TERMINAL_FLAG; }
+    void setTerminal() { _flags.fetch_or(TERMINAL_FLAG, std::memory_order_relaxed); }
+
+    // the move of the node wins (or loses) for the side that made it whatever the opponent plays
+    bool isProvenWin() const { return _flags.load(std::memory_order_relaxed) & PROVEN_WIN_FLAG; }
+    bool isProvenLoss() const { return _flags.load(std::memory_order_relaxed) & PROVEN_LOSS_FLAG; }
+    bool isProven() const { return _flags.load(std::memory_order_relaxed) & (PROVEN_WIN_FLAG | PROVEN_LOSS_FLAG); }
+    void setProvenWin() { _flags.fetch_or(PROVEN_WIN_FLAG, std::memory_order_relaxed); }
+    void setProvenLoss() { _flags.fetch_or(PROVEN_LOSS_FLAG, std::memory_order_relaxed); }
+    // the children are every reply that doesn't lose at once, so all of them losing is a proof
+    bool areRepliesComplete() const { return _flags.load(std::memory_order_relaxed) & REPLIES_COMPLETE_FLAG; }
+    void setRepliesComplete() { _flags.fetch_or(REPLIES_COMPLETE_FLAG, std::memory_order_relaxed); }
+    // proves the node from its children, true if it is proven. A node whose pruned replies
+    // all lose isn't proven, it gets winPriorPlayouts won playouts once instead
+    bool updateProof(unsigned winPriorPlayouts);
+
+    // first of getChildrenCount() contiguous children, nullptr for a leaf
+    MCTSNode* getChildren() const { return _children.load(std::memory_order_acquire); }
+    unsigned short getChildrenCount() const { return _childrenCount; }
+
+    // Only one caller wins the right to expand the node, the others keep using it as a leaf.
+    bool tryStartExpansion() { return !(_flags.fetch_or(EXPANDING_FLAG, std::memory_order_acq_rel) & EXPANDING_FLAG); }
+    // The threats of a position are searched once, by the first search rooted at its node.
+    bool tryStartThreatSearch() { return !(_flags.fetch_or(THREATS_SEARCHED_FLAG, std::memory_order_relaxed) & THREATS_SEARCHED_FLAG); }
+    // Makes a fully initialized block of children visible to other threads at once.
+    void publishChildren(MCTSNode* children, unsigned short count);
 
     void setUserData(unsigned data) { _userData = data; }
     unsigned getUserData() const { return _userData; }
 
-    short __x = 0;
-    short __y = 0;
-    short __color = 0;
-    short __depth = 0;
+    static void updateMaxDepth(short depth);
 private:
-    MCTSNode* _head = nullptr;
-    MCTSNode* _next = nullptr;
-
-    MCTSNode* _parent = nullptr;
-
-    unsigned _playouts = 0;
-    unsigned _realPlayouts = 0;
-    short _childrenCount = 0;
-    float _score = 0.f;
-
-    bool _isTerminal = false;
-
+    static constexpr unsigned char TERMINAL_FLAG = 1;
+    static constexpr unsigned char EXPANDING_FLAG = 2;
+    static constexpr unsigned char PROVEN_WIN_FLAG = 4;
+    static constexpr unsigned char PROVEN_LOSS_FLAG = 8;
+    static constexpr unsigned char THREATS_SEARCHED_FLAG = 16;
+    static constexpr unsigned char REPLIES_COMPLETE_FLAG = 32;
+    static constexpr unsigned char WIN_PRIOR_FLAG = 64;
+
+    // hot
+    std::atomic<unsigned> _playouts = {0};
+    std::atomic<float> _score = {0.f};
+    std::atomic<unsigned> _virtualLoss = {0};
+    std::atomic<unsigned char> _flags = {0};
+    unsigned short _childrenCount = 0;
+    std::atomic<MCTSNode*> _children = {nullptr};
+
+    // cold
+    std::atomic<unsigned> _realPlayouts = {0};
     unsigned _userData = 0;
 };
 
+static_assert(sizeof(MCTSNode) <= 32, "MCTSNode is expected to fit two nodes per cache line");
+
 #endif // MCTSNODE_H
@@ -1,24 +1,78 @@
 #include "mctstree.h"
 #include <algorithm>
 #include <thread>
-#include <future>
 #include <math.h>
-#include <QDebug>
 #include "debug.h"
 
-unsigned MCTSTree::NODE_EXPLORATIONS_TO_EXPAND = 32;
+unsigned MCTSTreeBase::NODE_EXPLORATIONS_TO_EXPAND = 32;
+unsigned MCTSTreeBase::TREE_PARALLEL_ITERATIONS = 8;
+unsigned MCTSTreeBase::NODES_TO_PRUNE_PER_UPDATE = 4096;
+unsigned MCTSTreeBase::LEAF_PLAYOUTS_PER_THREAD = 1;
+unsigned MCTSTreeBase::PIPELINE_LEAVES_PER_THREAD = 2;
+unsigned MCTSTreeBase::ROOT_THREAT_SEARCH_NODES = 20000;
+unsigned MCTSTreeBase::ROOT_THREAT_SEARCH_MS = 50;
+unsigned MCTSTreeBase::LEAF_THREAT_SEARCH_NODES = 100;
+unsigned MCTSTreeBase::WIN_PRIOR_PLAYOUTS = 20;
+
+template<short SIZE>
+BasicMCTSTree<SIZE>::BasicMCTSTree(short evalColor, unsigned threadsCount, bool useHugePages)
+    : _nodes(useHugePages)
+{
+    _root = _nodes.allocate();
+    _rootBlock = {_root, 1};
 
-MCTSTree::MCTSTree(short evalColor) {
-    _root = new MCTSNode();
-    _root->setParent(nullptr);
+    _evalColor = evalColor;
+
+    unsigned int n = threadsCount > 0 ? threadsCount : std::thread::hardware_concurrency();
+    _maxTreads = std::min(std::max(n, _maxTreads), MAX_THREADS);
+    _threadPool = std::make_unique<ThreadPool>(_maxTreads - 1);
+    _searchBoards.resize(_maxTreads);
+    _playoutBoards.resize(_maxTreads);
+    _threatSearches.resize(_maxTreads);
+    for (unsigned i = 0; i < _maxTreads; ++i) {
+        _searchBoards[i].field.clear();
+        _playoutBoards[i].field.clear();
+    }
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::WorkerBoard::sync(const BitField& state) {
+    // only copied when the position the board was left at is not the requested one
+    auto history = field.getGameHistory();
+    auto stateHistory = state.getGameHistory();
+    if (history.size() != stateHistory.size() || !std::equal(history.begin(), history.end(), stateHistory.begin()) || field.getAvailableMoves().size() != state.getAvailableMoves().size()) {
+        field = state;
+        journal.clear();
+    }
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::reset(short evalColor) {
+    _blocksToPrune.clear();
+    _nodes.release();
+    _root = _nodes.allocate();
+    _rootBlock = {_root, 1};
+    _rootDepth = 0;
+
+    // scores are stored from the point of view of the evaluated color
+    if (_transpositions) {
+        _transpositions->clear();
+    }
 
     _evalColor = evalColor;
+}
 
-    unsigned int n = std::thread::hardware_concurrency();
-    _maxTreads = std::min(std::max(n, _maxTreads), 24u);
+template<short SIZE>
+void BasicMCTSTree<SIZE>::setTranspositionTableSize(size_t entriesCount) {
+    if (entriesCount == 0) {
+        _transpositions.reset();
+    } else {
+        _transpositions = std::make_unique<TranspositionTable>(entriesCount);
+    }
 }
 
-void MCTSTree::selectChild(short x, short y) {
+template<short SIZE>
+MCTSNode* BasicMCTSTree<SIZE>::findChild(MCTSNode* root, short x, short y) const {
     unsigned long userDataBlack = 0;
     userDataBlack = writePositionX(x, userDataBlack);
     userDataBlack = writePositionY(y, userDataBlack);
@@ -29,38 +83,62 @@ void MCTSTree::selectChild(short x, short y) {
     userDataWhite = writePositionY(y, userDataWhite);
     userDataWhite = writeColorData(WHITE_PIECE_COLOR, userDataWhite);
 
-    MCTSNode* node = _root->getChildHead();
-    while (node) {
-        if (node->getUserData() == userDataBlack || node->getUserData() == userDataWhite) {
-            break;
+    MCTSNode* children = root->getChildren();
+    unsigned short childrenCount = children ? root->getChildrenCount() : 0;
+    for (unsigned short i = 0; i < childrenCount; ++i) {
+        if (children[i].getUserData() == userDataBlack || children[i].getUserData() == userDataWhite) {
+            return &children[i];
         }
-        node = node->getNextNode();
     }
 
-    if (!node) {
+    return nullptr;
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::selectChild(short x, short y) {
+    MCTSNode* children = _root->getChildren();
+    unsigned short childrenCount = children ? _root->getChildrenCount() : 0;
+    MCTSNode* node = findChild(_root, x, y);
+
+    // the block holding the old root and every subtree next to the played move can't be reached any more
+    NodeBlock rootBlock = {children, childrenCount};
+    if (node) {
+        for (unsigned short i = 0; i < childrenCount; ++i) {
+            if (&children[i] != node && !children[i].isLeaf()) {
+                _blocksToPrune.push_back({children[i].getChildren(), children[i].getChildrenCount()});
+            }
+        }
+    } else {
+        if (children) {
+            _blocksToPrune.push_back(rootBlock);
+        }
+
         short color = extractColorData(_root->getUserData());
         unsigned long userData = 0;
         userData = writePositionX(x, userData);
         userData = writePositionY(y, userData);
         userData = writeColorData(getNextPlayerColor(color), userData);
 
-        node = new MCTSNode();
+        node = _nodes.allocate();
         node->setUserData(userData);
-        node->__x = x;
-        node->__y = y;
-        node->__color = getNextPlayerColor(color);
-        _root->addChild(node);
+        rootBlock = {node, 1};
     }
+    _nodes.recycle(_rootBlock.nodes, _rootBlock.count);
 
+    _rootBlock = rootBlock;
     _root = node;
+    _rootDepth++;
 }
 
-std::vector<AIMoveData> MCTSTree::getNodesData() const {
+template<short SIZE>
+std::vector<AIMoveData> BasicMCTSTree<SIZE>::getNodesData() const {
     std::vector<AIMoveData> result;
-    MCTSNode* node = _root->getChildHead();
+    MCTSNode* children = _root->getChildren();
+    unsigned short childrenCount = children ? _root->getChildrenCount() : 0;
     float rootVisits = _root->getPlayouts();
 
-    while (node) {
+    for (unsigned short i = 0; i < childrenCount; ++i) {
+        MCTSNode* node = &children[i];
         auto nodeUserData = node->getUserData();
         short x = extractPositionX(nodeUserData);
         short y = extractPositionY(nodeUserData);
@@ -69,35 +147,37 @@ std::vector<AIMoveData> MCTSTree::getNodesData() const {
         float nodeScore = node->getPlayouts() > 0 ? node->getScore() / node->getPlayouts() : 0.f;
 
         AIMoveData moveData;
-        moveData.position = getHashedPosition(x, y);
+        moveData.position = Geometry::getHashedPosition(x, y);
         moveData.scores = nodeScore;
         moveData.color = extractColorData(nodeUserData);
         moveData.nodeVisits = node->getPlayouts();
         moveData.selectionScore = nodeScore + nodeAddScore;
+        moveData.proof = node->isProvenWin() ? 1 : node->isProvenLoss() ? -1 : 0;
 
 
         result.push_back(moveData);
-        node = node->getNextNode();
     }
 
     return result;
 }
 
-std::vector<AIMoveData> MCTSTree::getBestPlayout(short x, short y) const {
+template<short SIZE>
+std::vector<AIMoveData> BasicMCTSTree<SIZE>::getBestPlayout(short x, short y) const {
     std::vector<AIMoveData> result;
-    auto node = _root->getChildHead();
-    while (node) {
-        auto nodeUserData = node->getUserData();
+    MCTSNode* children = _root->getChildren();
+    unsigned short childrenCount = children ? _root->getChildrenCount() : 0;
+    MCTSNode* node = nullptr;
+    for (unsigned short i = 0; i < childrenCount; ++i) {
+        auto nodeUserData = children[i].getUserData();
         short nodeX = extractPositionX(nodeUserData);
         short nodeY = extractPositionY(nodeUserData);
         if (nodeX == x && nodeY == y) {
+            node = &children[i];
             break;
         }
-
-        node = node->getNextNode();
     }
 
-    unsigned topIndex = node ? node->__depth : 0;
+    unsigned moveIndex = 1;
     while (node) {
         auto nodeUserData = node->getUserData();
         short x = extractPositionX(nodeUserData);
@@ -106,25 +186,25 @@ std::vector<AIMoveData> MCTSTree::getBestPlayout(short x, short y) const {
         float nodeScore = node->getPlayouts() > 0 ? node->getScore() / node->getPlayouts() : 0.f;
 
         AIMoveData moveData;
-        moveData.position = getHashedPosition(x, y);
+        moveData.position = Geometry::getHashedPosition(x, y);
         moveData.scores = nodeScore;
         moveData.color = extractColorData(nodeUserData);
         moveData.nodeVisits = node->getPlayouts();
         moveData.selectionScore = 0.f;
-        moveData.moveIndex = node->__depth - topIndex + 1;
+        moveData.moveIndex = moveIndex++;
 
         result.push_back(moveData);
 
-        auto child = node->getChildHead();
-        auto bestChild = child;
+        MCTSNode* child = node->getChildren();
+        unsigned short count = child ? node->getChildrenCount() : 0;
+        MCTSNode* bestChild = child;
         float bestScore = -100.f;
-        while (child) {
-            float childScore = child->getPlayouts() > 0 ? child->getScore() / child->getPlayouts() : 0.f;
+        for (unsigned short i = 0; i < count; ++i) {
+            float childScore = child[i].getPlayouts() > 0 ? child[i].getScore() / child[i].getPlayouts() : 0.f;
             if (childScore >= bestScore) {
                 bestScore = childScore;
-                bestChild = child;
+                bestChild = &child[i];
             }
-            child = child->getNextNode();
         }
         node = bestChild;
     }
@@ -132,11 +212,82 @@ std::vector<AIMoveData> MCTSTree::getBestPlayout(short x, short y) const {
     return result;
 }
 
-void MCTSTree::update(const BitField* const rootState) {
-    explore(_root, rootState);
+template<short SIZE>
+void BasicMCTSTree<SIZE>::update(const BitField* const rootState) {
+    pruneDiscardedNodes();
+    search(_root, rootState);
 }
 
-void MCTSTree::expand(MCTSNode* root, const BitField* const rootState) {
+template<short SIZE>
+bool BasicMCTSTree<SIZE>::ponder(short x, short y, const BitField* const replyState) {
+    MCTSNode* reply = findChild(_root, x, y);
+    if (!reply || reply->isProven()) {
+        return false;
+    }
+
+    pruneDiscardedNodes();
+    search(reply, replyState);
+    return true;
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::search(MCTSNode* root, const BitField* const rootState) {
+    if (ROOT_THREAT_SEARCH_NODES > 0 && root->tryStartThreatSearch()) {
+        WorkerBoard& board = _searchBoards[getWorkerIndex()];
+        board.sync(*rootState);
+        typename BasicThreatSearch<SIZE>::Limits limits = {ROOT_THREAT_SEARCH_NODES, ROOT_THREAT_SEARCH_MS};
+        if (!searchThreats(root, board, BasicThreatSearch<SIZE>::Mode::VCF, limits)) {
+            searchThreats(root, board, BasicThreatSearch<SIZE>::Mode::VCT, limits);
+        }
+    }
+
+    // the winning move is known, a lost position is still searched for the best defence
+    if (root->isProvenLoss()) {
+        return;
+    }
+
+    if (_searchMode == SearchMode::LEAF_PARALLEL) {
+        explore(root, rootState, false);
+        return;
+    }
+
+    if (_searchMode == SearchMode::PIPELINED) {
+        explorePipelined(root, rootState);
+        return;
+    }
+
+    TaskGroup workers;
+    for (unsigned i = 0; i < _maxTreads; ++i) {
+        _threadPool->submit(workers, [this, root, rootState]() {
+            for (unsigned iteration = 0; iteration < TREE_PARALLEL_ITERATIONS; ++iteration) {
+                explore(root, rootState, true);
+            }
+        });
+    }
+    _threadPool->wait(workers);
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::pruneDiscardedNodes() {
+    // bounded amount of work per update, so dropping a huge subtree never stalls the search
+    unsigned budget = NODES_TO_PRUNE_PER_UPDATE;
+    while (budget > 0 && !_blocksToPrune.empty()) {
+        NodeBlock block = _blocksToPrune.back();
+        _blocksToPrune.pop_back();
+
+        for (unsigned short i = 0; i < block.count; ++i) {
+            if (!block.nodes[i].isLeaf()) {
+                _blocksToPrune.push_back({block.nodes[i].getChildren(), block.nodes[i].getChildrenCount()});
+            }
+        }
+        _nodes.recycle(block.nodes, block.count);
+
+        budget -= std::min<unsigned>(budget, block.count);
+    }
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::expand(MCTSNode* root, const BitField* const rootState) {
     // create nodes
     if (rootState->getGameStatus() != 0) {
         return;
@@ -144,162 +295,394 @@ void MCTSTree::expand(MCTSNode* root, const BitField* const rootState) {
 
     short color = extractColorData(root->getUserData());
 
-    const auto& moves = rootState->getBestMoves(getNextPlayerColor(color));
-    for (const auto& move : moves) {
-        MCTSNode* child = new MCTSNode();
+    typename BitField::MovesBuffer buffer;
+    short replyColor = getNextPlayerColor(color);
+    auto moves = rootState->getBestMoves(replyColor, buffer);
+    unsigned short count = static_cast<unsigned short>(moves.size());
+    if (count == 0) {
+        return;
+    }
+
+    // the replies getBestMoves leaves out lose to a five, unless it pruned them by priority
+    const auto& attacks = rootState->getAttackPriorities(replyColor);
+    const auto& blocks = rootState->getDefencePriorities(replyColor);
+    if (count == rootState->getAvailableMoves().size() || !attacks.isEmpty(MOVE_PRIORITIES::IMMIDIATE) || !blocks.isEmpty(MOVE_PRIORITIES::IMMIDIATE)) {
+        root->setRepliesComplete();
+    }
+
+    MCTSNode* children = _nodes.allocate(count);
+    for (unsigned short i = 0; i < count; ++i) {
+        // reversed, selection ties resolve the same way as when children were a prepended list
+        short move = moves[count - i - 1];
 
         unsigned long userData = 0;
-        userData = writePositionX(extractHashedPositionX(move), userData);
-        userData = writePositionY(extractHashedPositionY(move), userData);
+        userData = writePositionX(Geometry::extractX(move), userData);
+        userData = writePositionY(Geometry::extractY(move), userData);
         userData = writeColorData(getNextPlayerColor(color), userData);
 
-        child->setUserData(userData);
-        child->__x = extractHashedPositionX(move);
-        child->__y = extractHashedPositionY(move);
-        child->__color = getNextPlayerColor(color);
-        root->addChild(child);
+        children[i].setUserData(userData);
+    }
+
+    root->publishChildren(children, count);
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::explore(MCTSNode* root, const BitField* const rootState, bool isTreeParallel) {
+    WorkerBoard& board = _searchBoards[getWorkerIndex()];
+    board.sync(*rootState);
+    BitField& field = board.field;
+
+    Descent descent;
+    MCTSNode* node = selectLeaf(root, board, descent, isTreeParallel);
+
+    Debug::getInstance().startTrack(DebugTimeTracks::AI_UPDATE);
+    float playoutScore = 0;
+    unsigned playouts = 1;
+    if (node->isProven()) {
+        playoutScore = getProvenScore(node);
+    } else if (field.getGameStatus() != 0) {
+        playoutScore = getGameScore(field);
+    } else if (isTreeParallel) {
+        playoutScore = playoutInPlace(board, extractColorData(node->getUserData()));
+    } else {
+        short moveColor = extractColorData(node->getUserData());
+        unsigned threadPlayouts = std::max(LEAF_PLAYOUTS_PER_THREAD, 1u);
+        std::array<float, MAX_THREADS> scores = {0.f};
+        TaskGroup playoutTasks;
+        for (unsigned i = 0; i < _maxTreads; ++i) {
+            _threadPool->submit(playoutTasks, [this, &scores, &field, moveColor, threadPlayouts, i]() {
+                scores[i] = playout(&field, moveColor, threadPlayouts);
+            });
+        }
+        _threadPool->wait(playoutTasks);
+
+        for (unsigned i = 0; i < _maxTreads; ++i) {
+            playoutScore += scores[i];
+        }
+
+        playoutScore = playoutScore / static_cast<float>(_maxTreads);
+        playouts = _maxTreads * threadPlayouts;
     }
+    Debug::getInstance().stopTrack(DebugTimeTracks::AI_UPDATE);
+
+    backpropagate(board, descent, playoutScore, playouts, isTreeParallel);
 }
 
-void MCTSTree::explore(MCTSNode* root, const BitField* const rootState) {
+template<short SIZE>
+MCTSNode* BasicMCTSTree<SIZE>::selectLeaf(MCTSNode* root, WorkerBoard& board, Descent& descent, bool withVirtualLoss) {
     Debug::getInstance().startTrack(DebugTimeTracks::NODE_SELECTION);
+    BitField& field = board.field;
     MCTSNode* node = root;
-    BitField field(*rootState);
-    while (node->getChildHead()) {
-        MCTSNode* nextNode = selectBestChild(node, &field);
-        node = nextNode;
+    descent.depth = 0;
+    descent.movesCount = 0;
+    if (withVirtualLoss) {
+        root->addVirtualLoss();
+    }
+    descent.hashes[descent.depth] = field.getHash();
+    descent.path[descent.depth++] = root;
+    // a proven node below the root isn't searched any further, its result is known
+    while (!node->isLeaf() && (node == root || !node->isProven())) {
+        node = selectBestChild(node, &field);
+        if (withVirtualLoss) {
+            node->addVirtualLoss();
+        }
+        descent.path[descent.depth++] = node;
 
         short x = extractPositionX(node->getUserData());
         short y = extractPositionY(node->getUserData());
         short color = extractColorData(node->getUserData());
 
-        field.makeMove(x, y, color);
+        if (field.makeMove(x, y, color, &board.journal)) {
+            descent.movesCount++;
+        }
+        descent.hashes[descent.depth - 1] = field.getHash();
     }
 
     if (field.getGameStatus() == BLACK_PIECE_COLOR || field.getGameStatus() == WHITE_PIECE_COLOR) {
         node->setTerminal();
+        node->setProvenWin();
     }
-
+    MCTSNode::updateMaxDepth(_rootDepth + descent.depth - 1);
     Debug::getInstance().stopTrack(DebugTimeTracks::NODE_SELECTION);
 
-    Debug::getInstance().startTrack(DebugTimeTracks::AI_UPDATE);
-    float playoutScore = 0;
-    unsigned playouts = 1;
-    if (field.getGameStatus() != 0) {
-        if (field.getGameStatus() == _evalColor) {
-            playoutScore = 1.f;
-        } else if (field.getGameStatus() == getNextPlayerColor(_evalColor)) {
-            playoutScore = -1.f;
+    return node;
+}
+
+template<short SIZE>
+void BasicMCTSTree<SIZE>::backpropagate(WorkerBoard& board, Descent& descent, float playoutScore, unsigned playouts, bool withVirtualLoss) {
+    Debug::getInstance().startTrack(DebugTimeTracks::TRAVERSE_AND_EXPAND);
+    MCTSNode* node = descent.path[descent.depth - 1];
+    unsigned depth = descent.depth;
+    while (depth > 0) {
+        MCTSNode* traversBackNode = descent.path[--depth];
+        short color = extractColorData(traversBackNode->getUserData());
+
+        float nodeScore = color == _evalColor ? playoutScore : -playoutScore;
+        traversBackNode->addScore(nodeScore);
+        traversBackNode->addPlayout();
+        traversBackNode->addRealPlayouts(playouts);
+        if (_transpositions) {
+            auto entry = _transpositions->findOrReplace(descent.hashes[depth]);
+            if (entry) {
+                entry->add(nodeScore);
+            }
         }
-    } else {
-        short moveColor = extractColorData(node->getUserData());
-        std::vector<std::future<float>> threads;
-        for (unsigned i = 0; i < _maxTreads; ++i) {
-            threads.push_back(std::async([this](const BitField* const rootState, short rootColor) {
-                return playout(rootState, rootColor);
-            }, &field, moveColor));
+        if (withVirtualLoss) {
+            traversBackNode->removeVirtualLoss();
         }
+    }
 
-        for (auto& result : threads) {
-            playoutScore += result.get();
+    if (node->isLeaf() && node->getRealPlayouts() >= NODE_EXPLORATIONS_TO_EXPAND && node->tryStartExpansion()) {
+        expand(node, &board.field);
+        if (LEAF_THREAT_SEARCH_NODES > 0) {
+            searchThreats(node, board, BasicThreatSearch<SIZE>::Mode::VCF, {LEAF_THREAT_SEARCH_NODES});
         }
+    }
 
-        playoutScore = playoutScore / static_cast<float>(_maxTreads);
-        playouts = _maxTreads;
+    // proofs climb as long as the parent gets proven by them
+    for (unsigned proofDepth = descent.depth - 1; proofDepth > 0 && descent.path[proofDepth]->isProven(); --proofDepth) {
+        if (!descent.path[proofDepth - 1]->updateProof(WIN_PRIOR_PLAYOUTS)) {
+            break;
+        }
+    }
 
-//        playoutScore = playout(&field, moveColor);
+    while (descent.movesCount > 0) {
+        board.field.unmakeMove(board.journal);
+        descent.movesCount--;
     }
+    Debug::getInstance().stopTrack(DebugTimeTracks::TRAVERSE_AND_EXPAND);
+}
 
-    Debug::getInstance().stopTrack(DebugTimeTracks::AI_UPDATE);
+template<short SIZE>
+void BasicMCTSTree<SIZE>::explorePipelined(MCTSNode* root, const BitField* const rootState) {
+    if (_pipelineSlots.size() != _maxTreads * PIPELINE_LEAVES_PER_THREAD) {
+        _pipelineSlots = std::vector<PipelineSlot>(_maxTreads * PIPELINE_LEAVES_PER_THREAD);
+    }
 
-    Debug::getInstance().startTrack(DebugTimeTracks::TRAVERSE_AND_EXPAND);
-    MCTSNode* traversBackNode = node;
-    while (traversBackNode) {
-        short color = extractColorData(traversBackNode->getUserData());
+    std::vector<unsigned> freeSlots;
+    for (unsigned i = 0; i < _pipelineSlots.size(); ++i) {
+        _pipelineSlots[i].board.sync(*rootState);
+        freeSlots.push_back(i);
+    }
 
-        traversBackNode->addScore(color == _evalColor ? playoutScore : -playoutScore);
-        traversBackNode->addPlayout();
-        traversBackNode->addRealPlayouts(playouts);
+    TaskGroup evaluations;
+    std::vector<unsigned> evaluated;
+    unsigned leavesToSelect = _maxTreads * TREE_PARALLEL_ITERATIONS;
+    unsigned pendingLeaves = 0;
+    while (leavesToSelect > 0 || pendingLeaves > 0) {
+        // the selector keeps every free slot busy with a new leaf
+        while (leavesToSelect > 0 && !freeSlots.empty()) {
+            unsigned index = freeSlots.back();
+            PipelineSlot& slot = _pipelineSlots[index];
+            MCTSNode* leaf = selectLeaf(root, slot.board, slot.descent, true);
+            leavesToSelect--;
+
+            if (leaf->isProven() || slot.board.field.getGameStatus() != 0) {
+                float score = leaf->isProven() ? getProvenScore(leaf) : getGameScore(slot.board.field);
+                backpropagate(slot.board, slot.descent, score, 1, true);
+                continue;
+            }
+
+            freeSlots.pop_back();
+            pendingLeaves++;
+            short moveColor = extractColorData(leaf->getUserData());
+            _threadPool->submit(evaluations, [this, index, moveColor]() {
+                PipelineSlot& evaluatedSlot = _pipelineSlots[index];
+                evaluatedSlot.score = playoutInPlace(evaluatedSlot.board, moveColor);
+
+                std::lock_guard<std::mutex> lock(_evaluatedSlotsMutex);
+                _evaluatedSlots.push_back(index);
+            });
+        }
 
-        traversBackNode = traversBackNode->getParent();
+        {
+            std::lock_guard<std::mutex> lock(_evaluatedSlotsMutex);
+            evaluated.swap(_evaluatedSlots);
+        }
+
+        // results are backed up in the order they arrive
+        for (unsigned index : evaluated) {
+            PipelineSlot& slot = _pipelineSlots[index];
+            backpropagate(slot.board, slot.descent, slot.score, 1, true);
+            freeSlots.push_back(index);
+            pendingLeaves--;
+        }
+
+        // nothing arrived yet, the selector evaluates a leaf itself instead of idling
+        if (evaluated.empty() && pendingLeaves > 0 && !_threadPool->runPendingTask()) {
+            std::this_thread::yield();
+        }
+        evaluated.clear();
     }
 
-    if (node->isLeaf() && node->getRealPlayouts() >= NODE_EXPLORATIONS_TO_EXPAND) {
-        expand(node, &field);
+    _threadPool->wait(evaluations);
+}
+
+template<short SIZE>
+float BasicMCTSTree<SIZE>::getGameScore(const BitField& field) const {
+    if (field.getGameStatus() == _evalColor) {
+        return 1.f;
+    } else if (field.getGameStatus() == getNextPlayerColor(_evalColor)) {
+        return -1.f;
     }
-    Debug::getInstance().stopTrack(DebugTimeTracks::TRAVERSE_AND_EXPAND);
+
+    return 0.f;
 }
 
-MCTSNode* MCTSTree::selectBestChild(MCTSNode* root, const BitField* const rootState) const {
-    unsigned long rootVisits = root->getPlayouts();
+template<short SIZE>
+bool BasicMCTSTree<SIZE>::searchThreats(MCTSNode* node, WorkerBoard& board, typename BasicThreatSearch<SIZE>::Mode mode, const typename BasicThreatSearch<SIZE>::Limits& limits) {
+    if (node->isProven() || board.field.getGameStatus() != 0) {
+        return false;
+    }
+
+    short color = getNextPlayerColor(extractColorData(node->getUserData()));
+    short move = -1;
+    if (!_threatSearches[getWorkerIndex()].solve(board.field, board.journal, color, mode, limits, &move)) {
+        return false;
+    }
+
+    if (node->isLeaf() && node->tryStartExpansion()) {
+        expand(node, &board.field);
+    }
+
+    MCTSNode* child = findChild(node, Geometry::extractX(move), Geometry::extractY(move));
+    if (!child) {
+        return true;
+    }
+
+    if (mode == BasicThreatSearch<SIZE>::Mode::VCF) {
+        // the win is proven through the child of its first move, the caller backs it up
+        child->setProvenWin();
+        node->updateProof(WIN_PRIOR_PLAYOUTS);
+    } else {
+        // scores are kept for the mover of the node
+        child->addPlayouts(WIN_PRIOR_PLAYOUTS);
+        child->addScore(WIN_PRIOR_PLAYOUTS);
+    }
+
+    return true;
+}
+
+template<short SIZE>
+float BasicMCTSTree<SIZE>::getProvenScore(const MCTSNode* node) const {
+    float score = extractColorData(node->getUserData()) == _evalColor ? 1.f : -1.f;
+    return node->isProvenWin() ? score : -score;
+}
+
+template<short SIZE>
+MCTSNode* BasicMCTSTree<SIZE>::selectBestChild(MCTSNode* root, const BitField* const rootState) const {
+    unsigned long rootVisits = root->getPlayouts() + root->getVirtualLoss();
     float bestScore = -1000.f;
-    MCTSNode* bestNode = root->getChildHead();
-    MCTSNode* node = root->getChildHead();
+    MCTSNode* children = root->getChildren();
+    unsigned short childrenCount = root->getChildrenCount();
+    MCTSNode* bestNode = children;
 
     double p = 1.f - std::min(root->getPlayouts() / 500000.0, 1.0);
     double rndHit = ((double) rand() / (RAND_MAX));
     int rndChildIndex = -1;
     if (p < rndHit) {
-        rndChildIndex = rand() % root->getChildrenCount();
-
-        MCTSNode* randomNode = root->getChildHead();
-        while (randomNode && rndChildIndex > 0) {
-            rndChildIndex--;
-
-            randomNode = randomNode->getNextNode();
+        rndChildIndex = rand() % childrenCount;
+        if (!children[rndChildIndex].isProven()) {
+            return &children[rndChildIndex];
         }
-
-        return randomNode;
     }
 
-    while (node && rootVisits > 0) {
-        float nodeAddScore = node->getPlayouts() > 0 ? std::sqrt(std::log(rootVisits) / sqrt(node->getPlayouts())) : rootVisits;
-        float nodeScore = node->getPlayouts() > 0 ? node->getScore() / node->getPlayouts() : 0.f;
+    for (unsigned short i = 0; i < childrenCount && rootVisits > 0; ++i) {
+        MCTSNode* node = &children[i];
+        // a winning move is always taken, a lost one is never sampled again
+        if (node->isProvenWin()) {
+            return node;
+        }
+        if (node->isProvenLoss()) {
+            continue;
+        }
+
+        auto stats = getNodeStats(node, rootState->getHash());
+        // pending visits of other workers count as lost playouts, so they spread over different paths
+        unsigned virtualLoss = node->getVirtualLoss();
+        unsigned visits = stats.first + virtualLoss;
+        float nodeAddScore = visits > 0 ? std::sqrt(std::log(rootVisits) / sqrt(visits)) : rootVisits;
+        float nodeScore = visits > 0 ? (stats.second - virtualLoss * MCTSNode::VIRTUAL_LOSS) / visits : 0.f;
 
 //        short x = extractPositionX(node->getUserData());
 //        short y = extractPositionY(node->getUserData());
 //        short color = extractColorData(node->getUserData());
-        float nodePriority = 0;//rootState->getMovePriority(getHashedPosition(x, y), color) / 5.f;
-        if (node->isTerminal()) {
-            nodeScore += 100;
-        }
+        float nodePriority = 0;//rootState->getMovePriority(Geometry::getHashedPosition(x, y), color) / 5.f;
 
         float totalScore = nodeScore + nodeAddScore + nodePriority;
         if (totalScore >= bestScore) {
             bestScore = totalScore;
             bestNode = node;
         }
-
-        node = node->getNextNode();
     }
 
     return bestNode;
 }
 
-float MCTSTree::playout(const BitField* const rootState, short rootColor) {
+template<short SIZE>
+std::pair<unsigned, float> BasicMCTSTree<SIZE>::getNodeStats(const MCTSNode* node, uint64_t parentHash) const {
+    if (_transpositions) {
+        // the shared entry holds the visits of this node plus those of its transpositions
+        auto userData = node->getUserData();
+        short position = Geometry::getHashedPosition(extractPositionX(userData), extractPositionY(userData));
+        auto entry = _transpositions->find(parentHash ^ getZobristKey(position, extractColorData(userData)));
+        if (entry && entry->getPlayouts() > node->getPlayouts()) {
+            return {entry->getPlayouts(), entry->getScore()};
+        }
+    }
+
+    return {node->getPlayouts(), node->getScore()};
+}
+
+template<short SIZE>
+unsigned BasicMCTSTree<SIZE>::getWorkerIndex() const {
+    // the thread calling update() isn't a pool worker and gets the first board
+    return _threadPool->getCurrentWorker() + 1;
+}
+
+template<short SIZE>
+float BasicMCTSTree<SIZE>::playout(const BitField* const rootState, short rootColor, unsigned count) {
+    WorkerBoard& board = _playoutBoards[getWorkerIndex()];
+    board.sync(*rootState);
+
+    float score = 0.f;
+    for (unsigned i = 0; i < count; ++i) {
+        score += playoutInPlace(board, rootColor);
+    }
+
+    return count > 0 ? score / static_cast<float>(count) : 0.f;
+}
+
+template<short SIZE>
+float BasicMCTSTree<SIZE>::playoutInPlace(WorkerBoard& board, short rootColor) {
+    BitField& field = board.field;
     short x = 0;
     short y = 0;
     short color = rootColor;
+    unsigned movesCount = 0;
 
-    BitField field(*rootState);
     while (field.getGameStatus() == 0) {
         // find move position
         color = getNextPlayerColor(color);
 
         auto move = field.getMoveByPriority(color);
-        x = extractHashedPositionX(move);
-        y = extractHashedPositionY(move);
+        x = Geometry::extractX(move);
+        y = Geometry::extractY(move);
 
-        if (!field.makeMove(x, y, color)) {
+        if (!field.makeMove(x, y, color, &board.journal)) {
             break;
         }
+        movesCount++;
     }
 
-    if (field.getGameStatus() == _evalColor) {
-        return 1.f;
-    } else if (field.getGameStatus() == getNextPlayerColor(_evalColor)) {
-        return -1.f;
+    float result = getGameScore(field);
+    while (movesCount-- > 0) {
+        field.unmakeMove(board.journal);
     }
 
-    return 0.f;
+    return result;
 }
+
+template class BasicMCTSTree<15>;
+template class BasicMCTSTree<19>;
+template class BasicMCTSTree<LARGE_BOARD_SIZE>;
@@ -2,39 +2,178 @@
 #define MCTSTREE_H
 
 #include "mctsnode.h"
+#include "nodearena.h"
+#include "searcher.h"
 #include "bitfield.h"
 #include "common.h"
+#include "threadpool.h"
+#include "threatsearch.h"
+#include "transpositiontable.h"
+#include <memory>
+#include <mutex>
 
-class MCTSTree
+// search settings shared by the trees of every board size
+class MCTSTreeBase
 {
 public:
-    MCTSTree(short evalColor);
+    enum class SearchMode {
+        // one tree walker, every leaf is evaluated by a batch of parallel playouts
+        LEAF_PARALLEL,
+        // every worker walks, expands and backs up the shared tree on its own
+        TREE_PARALLEL,
+        // one selector queues leaves under virtual loss, the workers evaluate them and the
+        // selector backs every result up as it arrives
+        PIPELINED
+    };
 
-    void selectChild(short x, short y);
-    void update(const BitField* const rootState);
+    static constexpr unsigned MAX_THREADS = 24;
+    static unsigned NODE_EXPLORATIONS_TO_EXPAND;
+    // explore() iterations every worker runs per update() in tree-parallel mode,
+    // leaves evaluated per worker and update() in pipelined mode
+    static unsigned TREE_PARALLEL_ITERATIONS;
+    // discarded nodes recycled at the start of every update()
+    static unsigned NODES_TO_PRUNE_PER_UPDATE;
+    // playouts every thread runs from a leaf in leaf-parallel mode
+    static unsigned LEAF_PLAYOUTS_PER_THREAD;
+    // leaves waiting for or under evaluation per thread in pipelined mode
+    static unsigned PIPELINE_LEAVES_PER_THREAD;
+    // threat search budgets, 0 nodes turns it off: a VCF and a VCT once per searched root
+    // position and a VCF at every expanded leaf
+    static unsigned ROOT_THREAT_SEARCH_NODES;
+    static unsigned ROOT_THREAT_SEARCH_MS;
+    static unsigned LEAF_THREAT_SEARCH_NODES;
+    // won playouts a move that likely wins starts with: the first move of a VCT win, or a move
+    // whose replies all lose but were pruned by getBestMoves. Neither is a proof
+    static unsigned WIN_PRIOR_PLAYOUTS;
+};
+
+template<short SIZE>
+class BasicMCTSTree : public MCTSTreeBase, public BasicSearcher<SIZE>
+{
+public:
+    using BitField = BasicBitField<SIZE>;
+    using Geometry = typename BitField::Geometry;
+
+    // threadsCount 0 picks the hardware concurrency
+    BasicMCTSTree(short evalColor, unsigned threadsCount = 0, bool useHugePages = false);
+
+    // drops every node at once and starts a new game
+    void reset(short evalColor) override;
 
-    std::vector<AIMoveData> getNodesData() const;
+    void setSearchMode(SearchMode mode) { _searchMode = mode; }
+    SearchMode getSearchMode() const { return _searchMode; }
+
+    // shares node statistics between transpositions, 0 entries turns the table off
+    void setTranspositionTableSize(size_t entriesCount);
+    size_t getTranspositionTableSize() const { return _transpositions ? _transpositions->getEntriesCount() : 0; }
+
+    void selectChild(short x, short y) override;
+    void update(const BitField* const rootState) override;
+    // searches below the reply (x, y) of the root, replyState is the board after it,
+    // selectChild keeps what it found when the reply is played. False if there's no such child
+    bool ponder(short x, short y, const BitField* const replyState);
+
+    std::vector<AIMoveData> getNodesData() const override;
     std::vector<AIMoveData> getBestPlayout(short x, short y) const;
-    unsigned getTotalPlayouts() const { return _root ? _root->getRealPlayouts() : 0; }
+    unsigned getTotalPlayouts() const override { return _root ? _root->getRealPlayouts() : 0; }
     unsigned getChildrenCount() const { return _root ? _root->getChildrenCount() : 0; }
+    // the side to move has a proven win, getNodesData tells the winning move
+    bool isSolved() const override { return _root && _root->isProvenLoss(); }
 
     unsigned getThreadsCount() const { return _maxTreads; }
+    size_t getAllocatedNodes() const { return _nodes.getNodesCount(); }
+
+    // average score of count playouts
+    float playout(const BitField* const rootState, short rootColor, unsigned count = 1);
 private:
+    // a board some thread searches on in place, with the journal to take its moves back
+    struct WorkerBoard {
+        BitField field;
+        typename BitField::UndoJournal journal;
+
+        void sync(const BitField& state);
+    };
+
+    // plays a random game on the board and takes it back before returning
+    float playoutInPlace(WorkerBoard& board, short rootColor);
+    // index of the boards of the calling thread
+    unsigned getWorkerIndex() const;
+
+    void pruneDiscardedNodes();
     void expand(MCTSNode* root, const BitField* const rootState);
-    float playout(const BitField* const rootState, short rootColor);
-    void explore(MCTSNode* root, const BitField* const rootState);
+    // nodes and position hashes from the root to a selected leaf
+    struct Descent {
+        std::array<MCTSNode*, BitField::LENGTH + 1> path;
+        std::array<uint64_t, BitField::LENGTH + 1> hashes;
+        unsigned depth = 0;
+        unsigned movesCount = 0;
+    };
+
+    // a leaf of the pipeline with the board standing on it
+    struct PipelineSlot {
+        WorkerBoard board;
+        Descent descent;
+        float score = 0.f;
+    };
+
+    void explore(MCTSNode* root, const BitField* const rootState, bool isTreeParallel);
+    // one update() worth of search below root
+    void search(MCTSNode* root, const BitField* const rootState);
+    void explorePipelined(MCTSNode* root, const BitField* const rootState);
+    MCTSNode* findChild(MCTSNode* root, short x, short y) const;
+    // walks the board from the root position down to a leaf
+    MCTSNode* selectLeaf(MCTSNode* root, WorkerBoard& board, Descent& descent, bool withVirtualLoss);
+    // scores the path, expands the leaf when it is due and takes the moves of the walk back
+    void backpropagate(WorkerBoard& board, Descent& descent, float playoutScore, unsigned playouts, bool withVirtualLoss);
+    float getGameScore(const BitField& field) const;
+    // exact score of a node whose result is proven
+    float getProvenScore(const MCTSNode* node) const;
+
+    // the side to move on board wins by threats: a VCF proves node lost for its mover,
+    // a VCT only gives the first move of the win a head start. False without a win
+    bool searchThreats(MCTSNode* node, WorkerBoard& board, typename BasicThreatSearch<SIZE>::Mode mode, const typename BasicThreatSearch<SIZE>::Limits& limits);
 
     MCTSNode* selectBestChild(MCTSNode* root, const BitField* const rootState) const;
+    std::pair<unsigned, float> getNodeStats(const MCTSNode* node, uint64_t parentHash) const;
 private:
+    struct NodeBlock {
+        MCTSNode* nodes = nullptr;
+        unsigned short count = 0;
+    };
+
+    NodeArena _nodes;
     MCTSNode* _root;
-    BitField* _currentState;
+    // sibling block the root lives in, it goes back to the arena once the root moves on
+    NodeBlock _rootBlock;
+    short _rootDepth = 0;
+    // children blocks of discarded subtrees waiting to be handed back to the arena
+    std::vector<NodeBlock> _blocksToPrune;
 
     short _evalColor = 0;
     unsigned _maxTreads = 1;
+    SearchMode _searchMode = SearchMode::LEAF_PARALLEL;
 
-    std::array<unsigned, BOARD_LENGTH> _nodePlayouts;
-public:
-    static unsigned NODE_EXPLORATIONS_TO_EXPAND;
+    std::unique_ptr<TranspositionTable> _transpositions;
+
+    // playout workers, the thread calling update() runs playouts as well
+    std::unique_ptr<ThreadPool> _threadPool;
+
+    // one board per thread, kept at the root (or leaf) position between iterations
+    std::vector<WorkerBoard> _searchBoards;
+    std::vector<WorkerBoard> _playoutBoards;
+    std::vector<BasicThreatSearch<SIZE>> _threatSearches;
+
+    std::vector<PipelineSlot> _pipelineSlots;
+    // slots the workers have evaluated and the selector hasn't backed up yet
+    std::vector<unsigned> _evaluatedSlots;
+    std::mutex _evaluatedSlotsMutex;
 };
 
+// instantiated in mctstree.cpp
+extern template class BasicMCTSTree<15>;
+extern template class BasicMCTSTree<19>;
+extern template class BasicMCTSTree<LARGE_BOARD_SIZE>;
+
+using MCTSTree = BasicMCTSTree<BOARD_SIZE>;
+
 #endif // MCTSTREE_H
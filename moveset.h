@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common.h"
+#include <cassert>
+#include <cstdlib>
+
+// Sparse set of board cells: a dense array of the moves plus the position of every move in it.
+// Insert, erase, lookup and random pick are O(1), erasing moves the last move into the hole.
+template<short LENGTH>
+class MoveSet
+{
+public:
+    void clear() { _count = 0; }
+
+    bool contains(short move) const {
+        return _indices[move] < _count && _moves[_indices[move]] == move;
+    }
+
+    // puts the move at index and the move that was there to the end, so inserting a move at
+    // the index erase() returned for it brings back the exact order
+    void insert(short move, unsigned short index) {
+        assert(!contains(move) && index <= _count);
+        if (index < _count) {
+            short displaced = _moves[index];
+            _moves[_count] = displaced;
+            _indices[displaced] = _count;
+        }
+        _moves[index] = move;
+        _indices[move] = index;
+        _count++;
+    }
+
+    void insert(short move) { insert(move, _count); }
+
+    // returns the index the move was at
+    unsigned short erase(short move) {
+        assert(contains(move));
+        unsigned short index = _indices[move];
+        short last = _moves[--_count];
+        _moves[index] = last;
+        _indices[last] = index;
+
+        return index;
+    }
+
+    unsigned short size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    short operator[](unsigned short index) const { return _moves[index]; }
+
+    Span<short> getMoves() const { return {_moves.data(), _count}; }
+    short getRandomMove() const { return _moves[rand() % _count]; }
+private:
+    std::array<short, LENGTH> _moves = {0};
+    std::array<unsigned short, LENGTH> _indices = {0};
+    unsigned short _count = 0;
+};
@@ -0,0 +1,124 @@
+#include "nodearena.h"
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+static_assert(std::is_trivially_destructible<MCTSNode>::value, "NodeArena::release() never runs node destructors");
+
+NodeArena::NodeArena(bool useHugePages)
+    : _useHugePages(useHugePages)
+{
+    for (auto& slab : _slabs) {
+        slab.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+NodeArena::~NodeArena() {
+    for (auto& slab : _slabs) {
+        MCTSNode* nodes = slab.load(std::memory_order_relaxed);
+        if (nodes) {
+            freeSlab(nodes);
+        }
+    }
+}
+
+MCTSNode* NodeArena::allocate(unsigned short count) {
+    unsigned short capacity = getBlockCapacity(count);
+    MCTSNode* block = nullptr;
+
+    if (_freeBlocksCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(_freeBlocksMutex);
+        block = _freeBlocks[capacity];
+        if (block) {
+            _freeBlocks[capacity] = *std::launder(reinterpret_cast<MCTSNode**>(block));
+            _freeBlocksCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!block) {
+        // blocks never straddle two slabs, the tail of a slab that is too short is skipped
+        size_t index = _nextNode.load(std::memory_order_relaxed);
+        size_t start = 0;
+        do {
+            size_t offset = index % SLAB_NODES;
+            start = offset + capacity > SLAB_NODES ? index + SLAB_NODES - offset : index;
+        } while (!_nextNode.compare_exchange_weak(index, start + capacity, std::memory_order_relaxed));
+
+        size_t slabIndex = start / SLAB_NODES;
+        if (slabIndex >= MAX_SLABS) {
+            throw std::bad_alloc();
+        }
+
+        MCTSNode* slab = _slabs[slabIndex].load(std::memory_order_acquire);
+        if (!slab) {
+            std::lock_guard<std::mutex> lock(_slabsMutex);
+            slab = _slabs[slabIndex].load(std::memory_order_relaxed);
+            if (!slab) {
+                slab = allocateSlab();
+                _slabs[slabIndex].store(slab, std::memory_order_release);
+                _slabsCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        block = slab + start % SLAB_NODES;
+    }
+
+    for (unsigned short i = 0; i < count; ++i) {
+        new (block + i) MCTSNode();
+    }
+    _usedNodes.fetch_add(capacity, std::memory_order_relaxed);
+
+    return block;
+}
+
+void NodeArena::recycle(MCTSNode* block, unsigned short count) {
+    unsigned short capacity = getBlockCapacity(count);
+
+    std::lock_guard<std::mutex> lock(_freeBlocksMutex);
+    new (block) MCTSNode*(_freeBlocks[capacity]);
+    _freeBlocks[capacity] = block;
+    _freeBlocksCount.fetch_add(1, std::memory_order_relaxed);
+    _usedNodes.fetch_sub(capacity, std::memory_order_relaxed);
+}
+
+void NodeArena::release() {
+    std::lock_guard<std::mutex> lock(_freeBlocksMutex);
+    _freeBlocks.fill(nullptr);
+    _freeBlocksCount.store(0, std::memory_order_relaxed);
+    _nextNode.store(0, std::memory_order_relaxed);
+    _usedNodes.store(0, std::memory_order_relaxed);
+}
+
+MCTSNode* NodeArena::allocateSlab() {
+#ifdef __linux__
+    if (_useHugePages) {
+        void* memory = mmap(nullptr, SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED) {
+            // no reserved huge pages, ask for transparent ones instead
+            memory = mmap(nullptr, SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            madvise(memory, SLAB_BYTES, MADV_HUGEPAGE);
+        }
+
+        return static_cast<MCTSNode*>(memory);
+    }
+#endif
+
+    return static_cast<MCTSNode*>(::operator new(SLAB_BYTES, std::align_val_t(alignof(MCTSNode))));
+}
+
+void NodeArena::freeSlab(MCTSNode* slab) {
+#ifdef __linux__
+    if (_useHugePages) {
+        munmap(slab, SLAB_BYTES);
+        return;
+    }
+#endif
+
+    ::operator delete(slab, std::align_val_t(alignof(MCTSNode)));
+}
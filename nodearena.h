@@ -0,0 +1,58 @@
+#pragma once
+
+#include "mctsnode.h"
+#include "common.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+// Slab allocator for the nodes of one MCTSTree. Blocks of sibling nodes are carved out of
+// large slabs with a single atomic bump, so concurrent expansion never touches malloc, and
+// release() drops every node of the tree at once while keeping the slabs for the next game.
+// Blocks handed back with recycle() are kept in per-size free lists and reused before the
+// slabs grow.
+class NodeArena
+{
+public:
+    static constexpr size_t SLAB_BYTES = 4 * 1024 * 1024;
+    static constexpr size_t SLAB_NODES = SLAB_BYTES / sizeof(MCTSNode);
+    static constexpr size_t MAX_SLABS = 4096;
+    static constexpr size_t MAX_BLOCK_NODES = MAX_BOARD_LENGTH;
+
+    explicit NodeArena(bool useHugePages = false);
+    ~NodeArena();
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    // count contiguous, default constructed nodes
+    MCTSNode* allocate(unsigned short count = 1);
+    void recycle(MCTSNode* block, unsigned short count);
+    void release();
+
+    size_t getNodesCount() const { return _usedNodes.load(std::memory_order_relaxed); }
+    size_t getReservedBytes() const { return _slabsCount.load(std::memory_order_relaxed) * SLAB_BYTES; }
+private:
+    // blocks are rounded up to a multiple of 8 nodes past 8, so free lists get reused often
+    static constexpr unsigned short getBlockCapacity(unsigned short count) {
+        return count <= 8 ? count : (count + 7) & ~7;
+    }
+    static constexpr size_t FREE_LISTS_COUNT = ((MAX_BLOCK_NODES + 7) & ~7) + 1;
+
+    MCTSNode* allocateSlab();
+    void freeSlab(MCTSNode* slab);
+private:
+    std::array<std::atomic<MCTSNode*>, MAX_SLABS> _slabs;
+    std::atomic<size_t> _slabsCount = {0};
+    std::atomic<size_t> _nextNode = {0};
+    std::atomic<size_t> _usedNodes = {0};
+    std::mutex _slabsMutex;
+
+    // recycled blocks by capacity, linked through a pointer stored in their first node
+    std::array<MCTSNode*, FREE_LISTS_COUNT> _freeBlocks = {{nullptr}};
+    std::atomic<size_t> _freeBlocksCount = {0};
+    std::mutex _freeBlocksMutex;
+
+    bool _useHugePages = false;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "common.h"
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// a line of both players and the pattern window of its last cell have to fit a word,
+// see WideLines for wider boards
+constexpr bool canPackLines(short size, short windowCells) { return size - 1 + windowCells <= 32; }
+
+// Lines of one direction with the stones of both players in a single word per line:
+// black in the low half, white in the high half, bit i is cell i of the line.
+template<short SIZE, size_t LINES_COUNT>
+class PackedLines
+{
+public:
+    static constexpr short WHITE_SHIFT = 32;
+    static constexpr uint64_t LINE_MASK = (1ull << SIZE) - 1;
+
+    void clear() { _lines.fill(0); }
+
+    void set(unsigned line, short cell, short color) { _lines[line] |= getCellBit(cell, color); }
+    void reset(unsigned line, short cell, short color) { _lines[line] &= ~getCellBit(cell, color); }
+
+    uint64_t getStones(unsigned line, short color) const { return (_lines[line] >> getColorShift(color)) & LINE_MASK; }
+    bool hasStone(unsigned line, short cell, short color) const { return _lines[line] & getCellBit(cell, color); }
+    bool isEmpty(unsigned line, short cell) const { return !((_lines[line] | (_lines[line] >> WHITE_SHIFT)) & (1ull << cell)); }
+
+    // five or more stones in a row through cell, only the cells that can make such a row are read
+    bool hasRowOfFive(unsigned line, short cell, short color) const {
+        constexpr short REACH = MOVES_IN_ROW_TO_WIN - 1;
+        uint64_t row = ((getStones(line, color) << REACH) >> cell) & ((1ull << (REACH * 2 + 1)) - 1);
+        for (short i = 1; i < MOVES_IN_ROW_TO_WIN; ++i) {
+            row &= row >> 1;
+        }
+
+        return row != 0;
+    }
+
+    // cells from cell - BEFORE to cell + AFTER, black in the low CELLS bits and white above them,
+    // cells before the start of the line are set for both players
+    template<short BEFORE, short AFTER>
+    uint64_t getWindow(unsigned line, short cell) const {
+        constexpr short CELLS = BEFORE + AFTER + 1;
+        static_assert(canPackLines(SIZE, CELLS), "the window of the last cell has to fit half a word");
+        constexpr uint64_t CELLS_MASK = (1ull << CELLS) - 1;
+
+        uint64_t lines = _lines[line] << BEFORE;
+#ifdef __BMI2__
+        uint64_t window = _pext_u64(lines, (CELLS_MASK | (CELLS_MASK << WHITE_SHIFT)) << cell);
+#else
+        uint64_t window = ((lines >> cell) & CELLS_MASK) | (((lines >> (cell + WHITE_SHIFT)) & CELLS_MASK) << CELLS);
+#endif
+        uint64_t outside = ((1ull << BEFORE) - 1) >> cell;
+
+        return window | outside | (outside << CELLS);
+    }
+private:
+    static short getColorShift(short color) { return (color - 1) * WHITE_SHIFT; }
+    static uint64_t getCellBit(short cell, short color) { return 1ull << (cell + getColorShift(color)); }
+private:
+    std::array<uint64_t, LINES_COUNT> _lines = {0};
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "common.h"
+#include <cstdlib>
+
+// Moves partitioned by priority. Every bucket is a contiguous range of one dense array, so
+// changing the priority of a move costs one swap per priority step, and a bucket can be
+// sampled or handed out as a span without scanning the board.
+template<short LENGTH>
+class PriorityBuckets
+{
+public:
+    static constexpr short BUCKETS_COUNT = MOVE_PRIORITIES::IMMIDIATE + 1;
+
+    void clear() { _starts.fill(0); }
+
+    void insert(short move, short priority) {
+        // a new move starts right past the last bucket
+        _moves[_starts[BUCKETS_COUNT]] = move;
+        _indices[move] = _starts[BUCKETS_COUNT];
+        moveDown(move, BUCKETS_COUNT, priority);
+    }
+
+    void erase(short move, short priority) {
+        moveUp(move, priority, BUCKETS_COUNT);
+    }
+
+    void update(short move, short oldPriority, short newPriority) {
+        if (newPriority > oldPriority) {
+            moveUp(move, oldPriority, newPriority);
+        } else if (newPriority < oldPriority) {
+            moveDown(move, oldPriority, newPriority);
+        }
+    }
+
+    Span<short> getBucket(short priority) const {
+        return {_moves.data() + _starts[priority], static_cast<size_t>(_starts[priority + 1] - _starts[priority])};
+    }
+
+    bool isEmpty(short priority) const { return _starts[priority] == _starts[priority + 1]; }
+
+    // highest priority holding a move, 0 when there are none
+    short getMaxPriority() const {
+        for (short priority = BUCKETS_COUNT - 1; priority > 0; --priority) {
+            if (!isEmpty(priority)) {
+                return priority;
+            }
+        }
+
+        return 0;
+    }
+
+    short getRandomMove(short priority) const {
+        return _moves[_starts[priority] + rand() % (_starts[priority + 1] - _starts[priority])];
+    }
+
+    // slot of the move, taking back an erase or an update needs the one it had before
+    short getIndex(short move) const { return _indices[move]; }
+
+    // Take back the last insert, erase or update of the move, restoring the order of every
+    // bucket exactly. Changes of other moves made since then have to be taken back first.
+    void undoInsert(short move, short priority) {
+        unmove(move, BUCKETS_COUNT, priority, _starts[BUCKETS_COUNT] - 1);
+    }
+
+    void undoErase(short move, short priority, short index) {
+        _moves[_starts[BUCKETS_COUNT]] = move;
+        _indices[move] = _starts[BUCKETS_COUNT];
+        unmove(move, priority, BUCKETS_COUNT, index);
+    }
+
+    void undoUpdate(short move, short oldPriority, short newPriority, short index) {
+        unmove(move, oldPriority, newPriority, index);
+    }
+private:
+    void swap(short index, short otherIndex) {
+        short move = _moves[index];
+        short otherMove = _moves[otherIndex];
+        _moves[index] = otherMove;
+        _moves[otherIndex] = move;
+        _indices[otherMove] = index;
+        _indices[move] = otherIndex;
+    }
+
+    void moveUp(short move, short from, short to) {
+        for (short bucket = from; bucket < to; ++bucket) {
+            // last of its bucket, then the next bucket grows over it
+            swap(_indices[move], _starts[bucket + 1] - 1);
+            _starts[bucket + 1]--;
+        }
+    }
+
+    void moveDown(short move, short from, short to) {
+        for (short bucket = from; bucket > to; --bucket) {
+            swap(_indices[move], _starts[bucket]);
+            _starts[bucket]++;
+        }
+    }
+
+    // reverses moveUp or moveDown, the move passed every bucket between at one of its bounds,
+    // so only the slot it started at, index, isn't known
+    void unmove(short move, short from, short to, short index) {
+        for (short bucket = to - 1; bucket >= from; --bucket) {
+            _starts[bucket + 1]++;
+            swap(_indices[move], bucket == from ? index : _starts[bucket]);
+        }
+        for (short bucket = to + 1; bucket <= from; ++bucket) {
+            _starts[bucket]--;
+            swap(_indices[move], bucket == from ? index : _starts[bucket + 1] - 1);
+        }
+    }
+private:
+    std::array<short, LENGTH> _moves = {0};
+    // position of every move in _moves
+    std::array<short, LENGTH> _indices = {0};
+    // bucket p is [_starts[p], _starts[p + 1])
+    std::array<short, BUCKETS_COUNT + 1> _starts = {0};
+};
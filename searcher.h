@@ -0,0 +1,32 @@
+#pragma once
+
+#include "bitfield.h"
+#include "common.h"
+#include <vector>
+
+// What a search engine offers the app and the benchmark: it follows the game with selectChild,
+// searches a bounded amount more from the root position with every update() and reports the
+// root moves it has looked at.
+template<short SIZE>
+class BasicSearcher
+{
+public:
+    using BitField = BasicBitField<SIZE>;
+
+    virtual ~BasicSearcher() = default;
+
+    // drops everything searched and starts a new game
+    virtual void reset(short evalColor) = 0;
+    virtual void selectChild(short x, short y) = 0;
+    // rootState is the board after the moves selected so far
+    virtual void update(const BitField* const rootState) = 0;
+
+    // TimeManager::getBestMove picks the move to play from them
+    virtual std::vector<AIMoveData> getNodesData() const = 0;
+    // playouts, or positions searched, since the root was selected
+    virtual unsigned getTotalPlayouts() const = 0;
+    // the side to move has a proven win
+    virtual bool isSolved() const = 0;
+};
+
+using Searcher = BasicSearcher<BOARD_SIZE>;
@@ -0,0 +1,107 @@
+#include "searchthread.h"
+
+template<short SIZE>
+BasicSearchThread<SIZE>::BasicSearchThread(MCTSTree& tree)
+    : _tree(tree)
+{
+    _thread = std::thread(&BasicSearchThread::run, this);
+}
+
+template<short SIZE>
+BasicSearchThread<SIZE>::~BasicSearchThread() {
+    setCommand(Command::QUIT);
+    _thread.join();
+}
+
+template<short SIZE>
+void BasicSearchThread<SIZE>::start(const BitField& position, const TimeManager* timeManager) {
+    stop();
+    _position = position;
+    _timeManager = timeManager;
+    setCommand(Command::SEARCH);
+}
+
+template<short SIZE>
+void BasicSearchThread<SIZE>::ponder(const BitField& position) {
+    stop();
+    _position = position;
+    _timeManager = nullptr;
+
+    // the most visited reply is the one the search expects
+    unsigned bestVisits = 0;
+    short bestPosition = -1;
+    for (const auto& node : _tree.getNodesData()) {
+        if (node.nodeVisits > bestVisits) {
+            bestVisits = node.nodeVisits;
+            bestPosition = node.position;
+        }
+    }
+
+    _replyPosition = position;
+    _replyX = BitField::Geometry::extractX(bestPosition);
+    _replyY = BitField::Geometry::extractY(bestPosition);
+    short color = position.getGameHistory().empty() ? FIRST_MOVE_COLOR : getNextPlayerColor(position.getGameHistory().back()[2]);
+    if (bestPosition < 0 || !_replyPosition.makeMove(_replyX, _replyY, color) || _replyPosition.getGameStatus() != 0) {
+        // nothing to guess yet, the tree grows from the position itself
+        setCommand(Command::SEARCH);
+        return;
+    }
+
+    setCommand(Command::PONDER);
+}
+
+template<short SIZE>
+void BasicSearchThread<SIZE>::stop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_command != Command::QUIT) {
+        _command = Command::STOP;
+    }
+    _commandChanged.wait(lock, [this]() { return !_isBusy; });
+}
+
+template<short SIZE>
+void BasicSearchThread<SIZE>::setCommand(Command command) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _command = command;
+        _updatesCount.store(0, std::memory_order_relaxed);
+        _isFinished.store(false, std::memory_order_relaxed);
+    }
+    _commandChanged.notify_all();
+}
+
+template<short SIZE>
+void BasicSearchThread<SIZE>::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _isBusy = false;
+        _commandChanged.notify_all();
+        _commandChanged.wait(lock, [this]() { return _command != Command::STOP; });
+        if (_command == Command::QUIT) {
+            return;
+        }
+
+        _isBusy = true;
+        while (_command == Command::SEARCH || _command == Command::PONDER) {
+            Command command = _command;
+            lock.unlock();
+
+            if (command != Command::PONDER || !_tree.ponder(_replyX, _replyY, &_replyPosition)) {
+                _tree.update(&_position);
+            }
+            _updatesCount.fetch_add(1, std::memory_order_relaxed);
+            // a solved tree has nothing left to search
+            bool isDecided = _tree.isSolved() || (command == Command::SEARCH && _timeManager && _timeManager->shouldStop(_tree.getNodesData()));
+
+            lock.lock();
+            if (isDecided && _command == command) {
+                _command = Command::STOP;
+                _isFinished.store(command == Command::SEARCH, std::memory_order_release);
+            }
+        }
+    }
+}
+
+template class BasicSearchThread<15>;
+template class BasicSearchThread<19>;
+template class BasicSearchThread<LARGE_BOARD_SIZE>;
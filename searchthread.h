@@ -0,0 +1,75 @@
+#pragma once
+
+#include "bitfield.h"
+#include "mctstree.h"
+#include "timemanager.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Runs MCTSTree::update on a thread of its own until it is told to stop, so the search
+// doesn't share the caller's event loop. While the opponent thinks it ponders: it searches
+// below the reply the tree expects, and selectChild keeps that subtree when the guess was right.
+// The tree may only be used by the caller while the thread is stopped, the same goes for
+// the time manager a search is started with.
+template<short SIZE>
+class BasicSearchThread
+{
+public:
+    using BitField = BasicBitField<SIZE>;
+    using MCTSTree = BasicMCTSTree<SIZE>;
+
+    explicit BasicSearchThread(MCTSTree& tree);
+    ~BasicSearchThread();
+
+    BasicSearchThread(const BasicSearchThread&) = delete;
+    BasicSearchThread& operator=(const BasicSearchThread&) = delete;
+
+    // searches the moves of the side to move in position, until timeManager says the move is decided
+    void start(const BitField& position, const TimeManager* timeManager = nullptr);
+    // position is the one the opponent has to move in, searched below its most visited reply
+    void ponder(const BitField& position);
+    // returns once the thread is idle and the tree is free to use
+    void stop();
+
+    // the time manager stopped the search, the move can be played
+    bool isFinished() const { return _isFinished.load(std::memory_order_acquire); }
+    // update() calls since the last start() or ponder()
+    unsigned getUpdatesCount() const { return _updatesCount.load(std::memory_order_relaxed); }
+private:
+    enum class Command {
+        STOP,
+        SEARCH,
+        PONDER,
+        QUIT
+    };
+
+    void run();
+    void setCommand(Command command);
+private:
+    MCTSTree& _tree;
+
+    // written only while the thread is idle
+    BitField _position;
+    BitField _replyPosition;
+    short _replyX = -1;
+    short _replyY = -1;
+    const TimeManager* _timeManager = nullptr;
+
+    Command _command = Command::STOP;
+    bool _isBusy = false;
+    std::atomic<unsigned> _updatesCount = {0};
+    std::atomic<bool> _isFinished = {false};
+
+    std::mutex _mutex;
+    std::condition_variable _commandChanged;
+    std::thread _thread;
+};
+
+// instantiated in searchthread.cpp
+extern template class BasicSearchThread<15>;
+extern template class BasicSearchThread<19>;
+extern template class BasicSearchThread<LARGE_BOARD_SIZE>;
+
+using SearchThread = BasicSearchThread<BOARD_SIZE>;
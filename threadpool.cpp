@@ -0,0 +1,143 @@
+#include "threadpool.h"
+#include <algorithm>
+
+namespace {
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+}
+
+ThreadPool::ThreadPool(unsigned threadsCount) {
+    unsigned queuesCount = std::max(threadsCount, 1u);
+    for (unsigned i = 0; i < queuesCount; ++i) {
+        _queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (unsigned i = 0; i < threadsCount; ++i) {
+        _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _isStopping = true;
+    }
+    _wakeUp.notify_all();
+
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(TaskGroup& group, Task task) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned index = currentPool == this ? currentWorker : _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back({std::move(task), &group});
+    }
+    _queuedTasks.fetch_add(1, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _wakeUp.notify_one();
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    int index = currentPool == this ? currentWorker : -1;
+    QueuedTask task;
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        if (popTask(index, task) || stealTask(index, task)) {
+            runTask(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool ThreadPool::runPendingTask() {
+    int index = currentPool == this ? currentWorker : -1;
+    QueuedTask task;
+    if (popTask(index, task) || stealTask(index, task)) {
+        runTask(task);
+        return true;
+    }
+
+    return false;
+}
+
+int ThreadPool::getCurrentWorker() const {
+    return currentPool == this ? currentWorker : -1;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    currentPool = this;
+    currentWorker = static_cast<int>(index);
+
+    QueuedTask task;
+    while (true) {
+        if (popTask(index, task) || stealTask(index, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wakeUp.wait(lock, [this]() {
+            return _isStopping || _queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+
+        if (_isStopping) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::popTask(int index, QueuedTask& result) {
+    if (index < 0) {
+        return false;
+    }
+
+    auto& queue = *_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    result = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    _queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool ThreadPool::stealTask(int index, QueuedTask& result) {
+    if (_queuedTasks.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    unsigned queuesCount = static_cast<unsigned>(_queues.size());
+    unsigned start = index < 0 ? 0 : static_cast<unsigned>(index) + 1;
+    for (unsigned i = 0; i < queuesCount; ++i) {
+        auto& queue = *_queues[(start + i) % queuesCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        result = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        _queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::runTask(QueuedTask& task) {
+    task.task();
+    task.task = nullptr;
+    task.group->pending.fetch_sub(1, std::memory_order_release);
+}
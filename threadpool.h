@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks completion of a batch of tasks submitted to a ThreadPool.
+struct TaskGroup {
+    std::atomic<unsigned> pending = {0};
+};
+
+// Persistent work-stealing pool. Every worker owns a task deque: it pops its own tasks
+// from the back and steals from the front of the other queues when it runs dry.
+// Threads waiting on a TaskGroup run queued tasks instead of blocking.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(unsigned threadsCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned getThreadsCount() const { return static_cast<unsigned>(_workers.size()); }
+    // index of the pool thread running the caller, -1 for any other thread
+    int getCurrentWorker() const;
+
+    void submit(TaskGroup& group, Task task);
+    void wait(TaskGroup& group);
+    // runs one queued task on the calling thread, false when there was none
+    bool runPendingTask();
+private:
+    struct QueuedTask {
+        Task task;
+        TaskGroup* group = nullptr;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<QueuedTask> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool popTask(int index, QueuedTask& result);
+    bool stealTask(int index, QueuedTask& result);
+    void runTask(QueuedTask& task);
+private:
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+    std::vector<std::thread> _workers;
+
+    std::atomic<unsigned> _queuedTasks = {0};
+    std::atomic<unsigned> _nextQueue = {0};
+    std::atomic<bool> _isStopping = {false};
+
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeUp;
+};
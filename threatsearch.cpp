@@ -0,0 +1,163 @@
+#include "threatsearch.h"
+#include <algorithm>
+
+namespace {
+// nodes between two looks at the clock
+constexpr unsigned CLOCK_CHECK_NODES = 256;
+}
+
+template<short SIZE>
+bool BasicThreatSearch<SIZE>::solve(BitField& field, UndoJournal& journal, short color, Mode mode, const Limits& limits, short* move) {
+    _field = &field;
+    _journal = &journal;
+    _attacker = color;
+    _defender = getNextPlayerColor(color);
+    _mode = mode;
+    _limits = limits;
+
+    _nodesCount = 0;
+    _isAborted = false;
+    _start = Clock::now();
+    _nextClockCheck = 0;
+    _winningMove = -1;
+    _moves.clear();
+
+    if (field.getGameStatus() != 0) {
+        return false;
+    }
+
+    bool isWin = attack(0);
+    if (isWin && move) {
+        *move = _winningMove;
+    }
+
+    return isWin;
+}
+
+template<short SIZE>
+bool BasicThreatSearch<SIZE>::attack(unsigned depth) {
+    const PriorityBuckets<BitField::LENGTH>& attacks = _field->getAttackPriorities(_attacker);
+    if (!attacks.isEmpty(MOVE_PRIORITIES::IMMIDIATE)) {
+        short move = attacks.getBucket(MOVE_PRIORITIES::IMMIDIATE).front();
+        if (makeMove(move, _attacker)) {
+            bool isFive = _field->getGameStatus() == _attacker;
+            _field->unmakeMove(*_journal);
+            if (isFive) {
+                if (depth == 0) {
+                    _winningMove = move;
+                }
+                return true;
+            }
+        }
+    }
+
+    if (depth >= _limits.maxDepth || isOutOfBudget()) {
+        return false;
+    }
+
+    size_t first = _moves.size();
+    const PriorityBuckets<BitField::LENGTH>& blocks = _field->getDefencePriorities(_attacker);
+    if (!blocks.isEmpty(MOVE_PRIORITIES::IMMIDIATE)) {
+        // the defender has a four, the attacker keeps the initiative only if its block is a threat too
+        if (blocks.getBucket(MOVE_PRIORITIES::IMMIDIATE).size() > 1) {
+            return false;
+        }
+        pushMoves(blocks, MOVE_PRIORITIES::IMMIDIATE, MOVE_PRIORITIES::IMMIDIATE, first);
+    } else {
+        short minPriority = _mode == Mode::VCT ? MOVE_PRIORITIES::MEDIUM : MOVE_PRIORITIES::HIGH;
+        pushMoves(attacks, MOVE_PRIORITIES::IMMIDIATE - 1, minPriority, first);
+    }
+
+    bool isWin = false;
+    for (size_t i = first; i < _moves.size() && !isWin && !_isAborted; ++i) {
+        short move = _moves[i];
+        if (!makeMove(move, _attacker)) {
+            continue;
+        }
+
+        isWin = _field->getGameStatus() == _attacker || (_field->getGameStatus() == 0 && isThreat() && defend(depth));
+        _field->unmakeMove(*_journal);
+        if (isWin && depth == 0) {
+            _winningMove = move;
+        }
+    }
+    _moves.resize(first);
+
+    return isWin;
+}
+
+template<short SIZE>
+bool BasicThreatSearch<SIZE>::defend(unsigned depth) {
+    // a five of the defender beats any threat
+    if (!_field->getAttackPriorities(_defender).isEmpty(MOVE_PRIORITIES::IMMIDIATE)) {
+        return false;
+    }
+
+    size_t first = _moves.size();
+    const PriorityBuckets<BitField::LENGTH>& attacks = _field->getAttackPriorities(_attacker);
+    if (!attacks.isEmpty(MOVE_PRIORITIES::IMMIDIATE)) {
+        // a four, its fifth cell has to be taken
+        pushMoves(attacks, MOVE_PRIORITIES::IMMIDIATE, MOVE_PRIORITIES::IMMIDIATE, first);
+    } else {
+        // an open three, the open four is stopped or a four of the defender comes first
+        pushMoves(_field->getDefencePriorities(_defender), MOVE_PRIORITIES::IMMIDIATE, MOVE_PRIORITIES::URGENT, first);
+        pushMoves(_field->getAttackPriorities(_defender), MOVE_PRIORITIES::IMMIDIATE - 1, MOVE_PRIORITIES::HIGH, first);
+    }
+
+    // a threat without a known defence isn't trusted
+    bool isWin = _moves.size() > first;
+    for (size_t i = first; i < _moves.size() && isWin; ++i) {
+        if (!makeMove(_moves[i], _defender)) {
+            continue;
+        }
+
+        isWin = _field->getGameStatus() == 0 && attack(depth + 1);
+        _field->unmakeMove(*_journal);
+    }
+    _moves.resize(first);
+
+    return isWin && !_isAborted;
+}
+
+template<short SIZE>
+bool BasicThreatSearch<SIZE>::makeMove(short move, short color) {
+    _nodesCount++;
+    return _field->makeMove(BitField::Geometry::extractX(move), BitField::Geometry::extractY(move), color, _journal);
+}
+
+template<short SIZE>
+bool BasicThreatSearch<SIZE>::isOutOfBudget() {
+    if (_isAborted) {
+        return true;
+    }
+
+    if (_limits.maxNodes > 0 && _nodesCount >= _limits.maxNodes) {
+        _isAborted = true;
+    } else if (_limits.maxTimeMs > 0 && _nodesCount >= _nextClockCheck) {
+        _nextClockCheck = _nodesCount + CLOCK_CHECK_NODES;
+        _isAborted = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - _start).count() >= _limits.maxTimeMs;
+    }
+
+    return _isAborted;
+}
+
+template<short SIZE>
+bool BasicThreatSearch<SIZE>::isThreat() const {
+    const PriorityBuckets<BitField::LENGTH>& attacks = _field->getAttackPriorities(_attacker);
+    return !attacks.isEmpty(MOVE_PRIORITIES::IMMIDIATE) || (_mode == Mode::VCT && !attacks.isEmpty(MOVE_PRIORITIES::URGENT));
+}
+
+template<short SIZE>
+void BasicThreatSearch<SIZE>::pushMoves(const PriorityBuckets<BitField::LENGTH>& priorities, short fromPriority, short toPriority, size_t first) {
+    for (short priority = fromPriority; priority >= toPriority; --priority) {
+        for (short move : priorities.getBucket(priority)) {
+            if (std::find(_moves.begin() + first, _moves.end(), move) == _moves.end()) {
+                _moves.push_back(move);
+            }
+        }
+    }
+}
+
+template class BasicThreatSearch<15>;
+template class BasicThreatSearch<19>;
+template class BasicThreatSearch<LARGE_BOARD_SIZE>;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "bitfield.h"
+#include "common.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Threat-space search: looks for a win where every move of the attacker is a threat, so the
+// defender only ever has the few replies the priority buckets name. VCF plays fours only, the
+// defender has to take the fifth cell. VCT also plays threes, answered by the cells that stop
+// the open four or by a four of the defender's own. A win is only reported once every defence
+// the buckets allow ended in a five on the board. The only defence against a four is its fifth
+// cell, so a VCF win is a proof. The templates don't name every answer to a three (a three of
+// the defender's own, a far block), so a VCT win may not be one.
+template<short SIZE>
+class BasicThreatSearch
+{
+public:
+    using BitField = BasicBitField<SIZE>;
+    using UndoJournal = typename BitField::UndoJournal;
+
+    enum class Mode {
+        // victory by continuous fours
+        VCF,
+        // victory by continuous threats, fours and threes
+        VCT
+    };
+
+    // 0 turns a limit off
+    struct Limits {
+        unsigned maxNodes = 10000;
+        int64_t maxTimeMs = 0;
+        // moves of the attacker
+        unsigned maxDepth = 16;
+    };
+
+    // true when color, to move on field, wins by threats, *move is the first move of the win.
+    // Searches the board in place and leaves it as it was
+    bool solve(BitField& field, UndoJournal& journal, short color, Mode mode, const Limits& limits, short* move = nullptr);
+
+    // moves made by the last solve()
+    unsigned getNodesCount() const { return _nodesCount; }
+    // the last solve() ran out of budget, so no win found doesn't mean there is none
+    bool isAborted() const { return _isAborted; }
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool attack(unsigned depth);
+    // the attacker made a threat, true if every defence loses
+    bool defend(unsigned depth);
+    bool makeMove(short move, short color);
+    bool isOutOfBudget();
+
+    // the attacker made a four or, in VCT, an open three
+    bool isThreat() const;
+    // pushes the moves of the buckets fromPriority down to toPriority that aren't past first yet
+    void pushMoves(const PriorityBuckets<BitField::LENGTH>& priorities, short fromPriority, short toPriority, size_t first);
+private:
+    BitField* _field = nullptr;
+    UndoJournal* _journal = nullptr;
+    short _attacker = 0;
+    short _defender = 0;
+    Mode _mode = Mode::VCF;
+    Limits _limits;
+
+    unsigned _nodesCount = 0;
+    bool _isAborted = false;
+    Clock::time_point _start;
+    unsigned _nextClockCheck = 0;
+    short _winningMove = -1;
+
+    // candidates of every ply on the way down, the buckets change as soon as a move is made
+    std::vector<short> _moves;
+};
+
+// instantiated in threatsearch.cpp
+extern template class BasicThreatSearch<15>;
+extern template class BasicThreatSearch<19>;
+extern template class BasicThreatSearch<LARGE_BOARD_SIZE>;
+
+using ThreatSearch = BasicThreatSearch<BOARD_SIZE>;
@@ -0,0 +1,143 @@
+#include "timemanager.h"
+#include <algorithm>
+
+void TimeManager::setLimits(const Limits& limits) {
+    _limits = limits;
+    _remainingGameMs = limits.gameTimeMs;
+    _movesPlayed = 0;
+    _isMoveStarted = false;
+}
+
+void TimeManager::startMove(const std::vector<AIMoveData>& children) {
+    _isMoveStarted = true;
+    _moveStart = Clock::now();
+    _startVisits = getVisits(children);
+
+    _moveBudgetMs = _limits.moveTimeMs > 0 ? _limits.moveTimeMs : -1;
+    if (_limits.gameTimeMs > 0) {
+        unsigned movesToGo = std::max(MIN_MOVES_TO_GO, EXPECTED_GAME_MOVES - std::min(_movesPlayed, EXPECTED_GAME_MOVES));
+        int64_t share = _remainingGameMs / movesToGo + _limits.incrementMs;
+        // the increment only comes after the move, the clock itself is the hard limit
+        int64_t clockLimit = std::max<int64_t>(_remainingGameMs - SAFETY_MARGIN_MS, 0);
+        share = std::min(share, clockLimit);
+        _moveBudgetMs = _moveBudgetMs < 0 ? share : std::min(_moveBudgetMs, share);
+    }
+}
+
+void TimeManager::finishMove() {
+    if (!_isMoveStarted) {
+        return;
+    }
+
+    if (_limits.gameTimeMs > 0) {
+        _remainingGameMs += _limits.incrementMs - getElapsedMs();
+    }
+    _movesPlayed++;
+    _isMoveStarted = false;
+}
+
+bool TimeManager::shouldStop(const std::vector<AIMoveData>& children) const {
+    if (!_isMoveStarted) {
+        return false;
+    }
+
+    int64_t elapsedMs = getElapsedMs();
+    if (_moveBudgetMs >= 0 && elapsedMs >= _moveBudgetMs) {
+        return true;
+    }
+
+    unsigned visits = getVisits(children);
+    unsigned moveVisits = visits > _startVisits ? visits - _startVisits : 0;
+    if (_limits.movePlayouts > 0 && moveVisits >= _limits.movePlayouts) {
+        return true;
+    }
+
+    if (children.empty()) {
+        return false;
+    }
+    if (children.size() == 1) {
+        return true;
+    }
+
+    // a proven win is played at once, so is the only move not proven to lose
+    unsigned openMoves = 0;
+    bool isChosenByScore = false;
+    for (const auto& child : children) {
+        if (child.proof > 0) {
+            return true;
+        }
+        openMoves += child.proof == 0;
+        isChosenByScore = isChosenByScore || child.isChosen;
+    }
+    if (openMoves <= 1) {
+        return true;
+    }
+
+    // visits don't decide a move chosen by score, so they can't end its search early
+    if (isChosenByScore) {
+        return false;
+    }
+
+    // visits the rest of the budget is expected to add
+    double remaining = -1.;
+    if (_limits.movePlayouts > 0) {
+        remaining = _limits.movePlayouts - moveVisits;
+    }
+    if (_moveBudgetMs >= 0) {
+        if (elapsedMs < _moveBudgetMs * MIN_BUDGET_SHARE) {
+            return false;
+        }
+        double rate = static_cast<double>(moveVisits) / std::max<int64_t>(elapsedMs, 1);
+        double byTime = rate * (_moveBudgetMs - elapsedMs);
+        remaining = remaining < 0. ? byTime : std::min(remaining, byTime);
+    }
+    if (remaining < 0.) {
+        return false;
+    }
+
+    unsigned bestVisits = 0;
+    unsigned secondVisits = 0;
+    for (const auto& child : children) {
+        if (child.nodeVisits > bestVisits) {
+            secondVisits = bestVisits;
+            bestVisits = child.nodeVisits;
+        } else if (child.nodeVisits > secondVisits) {
+            secondVisits = child.nodeVisits;
+        }
+    }
+
+    return secondVisits + remaining < bestVisits;
+}
+
+short TimeManager::getBestMove(const std::vector<AIMoveData>& children) {
+    const AIMoveData* best = nullptr;
+    for (const auto& child : children) {
+        bool isBetter = !best || child.proof > best->proof;
+        if (best && child.proof == best->proof) {
+            bool isMoreVisited = child.nodeVisits > best->nodeVisits || (child.nodeVisits == best->nodeVisits && child.scores > best->scores);
+            isBetter = child.isChosen != best->isChosen ? child.isChosen : isMoreVisited;
+        }
+        if (isBetter) {
+            best = &child;
+        }
+    }
+
+    return best ? best->position : -1;
+}
+
+int64_t TimeManager::getElapsedMs() const {
+    if (!_isMoveStarted) {
+        return 0;
+    }
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - _moveStart).count();
+}
+
+unsigned TimeManager::getVisits(const std::vector<AIMoveData>& children) {
+    unsigned visits = 0;
+    for (const auto& child : children) {
+        visits += child.nodeVisits;
+    }
+
+    return visits;
+}
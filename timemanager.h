@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Decides when the search of a move is over. A move gets the smallest of its budgets: a fixed
+// time, a fixed number of playouts, or a share of the game clock plus the increment. The search
+// stops early once the remaining budget can't give the runner-up enough visits to pass the leader,
+// since the most visited move is the one played. A searcher that chooses its move by score
+// instead, like alpha-beta, runs to its budget. Proven moves decide the search at once.
+class TimeManager
+{
+public:
+    // 0 turns a limit off
+    struct Limits {
+        int64_t moveTimeMs = 0;
+        unsigned movePlayouts = 0;
+        // clock of the whole game, incrementMs is added to it after every move
+        int64_t gameTimeMs = 0;
+        int64_t incrementMs = 0;
+    };
+
+    // kept free on the game clock against the lag between a stop and the move
+    static constexpr int64_t SAFETY_MARGIN_MS = 50;
+    // the game clock is shared as if at least that many moves were left
+    static constexpr unsigned MIN_MOVES_TO_GO = 10;
+    static constexpr unsigned EXPECTED_GAME_MOVES = 40;
+    // part of the time budget spent before the playout rate is trusted for early stops
+    static constexpr double MIN_BUDGET_SHARE = 0.1;
+
+    // also starts a new game
+    void setLimits(const Limits& limits);
+    const Limits& getLimits() const { return _limits; }
+
+    // children are the root moves, the visits they already have don't count against the budget
+    void startMove(const std::vector<AIMoveData>& children);
+    // charges the move to the game clock
+    void finishMove();
+    bool isMoveStarted() const { return _isMoveStarted; }
+
+    bool shouldStop(const std::vector<AIMoveData>& children) const;
+
+    // the move the search settled on: a proven win, else the chosen or the most visited move not
+    // proven to lose. -1 without children
+    static short getBestMove(const std::vector<AIMoveData>& children);
+
+    int64_t getElapsedMs() const;
+    // time the current move may take, -1 when only playouts limit it
+    int64_t getMoveBudgetMs() const { return _moveBudgetMs; }
+    int64_t getRemainingGameMs() const { return _remainingGameMs; }
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static unsigned getVisits(const std::vector<AIMoveData>& children);
+private:
+    Limits _limits;
+
+    int64_t _remainingGameMs = 0;
+    unsigned _movesPlayed = 0;
+
+    bool _isMoveStarted = false;
+    Clock::time_point _moveStart;
+    int64_t _moveBudgetMs = -1;
+    unsigned _startVisits = 0;
+};
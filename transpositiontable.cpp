@@ -0,0 +1,70 @@
+#include "transpositiontable.h"
+#include <limits>
+
+TranspositionTable::TranspositionTable(size_t entriesCount) {
+    size_t bucketsCount = 1;
+    while (bucketsCount * 2 * BUCKET_SIZE <= entriesCount) {
+        bucketsCount *= 2;
+    }
+
+    _buckets = std::make_unique<Bucket[]>(bucketsCount);
+    _bucketsMask = bucketsCount - 1;
+}
+
+const TranspositionTable::Entry* TranspositionTable::find(uint64_t hash) const {
+    // 0 marks an empty entry, the empty board is never stored
+    if (hash == 0) {
+        return nullptr;
+    }
+
+    const Bucket& bucket = _buckets[hash & _bucketsMask];
+    for (const auto& entry : bucket.entries) {
+        if (entry.key.load(std::memory_order_acquire) == hash) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+TranspositionTable::Entry* TranspositionTable::findOrReplace(uint64_t hash) {
+    if (hash == 0) {
+        return nullptr;
+    }
+
+    Bucket& bucket = _buckets[hash & _bucketsMask];
+    Entry* victim = nullptr;
+    uint64_t victimKey = 0;
+    unsigned victimPlayouts = std::numeric_limits<unsigned>::max();
+    for (auto& entry : bucket.entries) {
+        uint64_t key = entry.key.load(std::memory_order_acquire);
+        if (key == hash) {
+            return &entry;
+        }
+
+        unsigned playouts = key == 0 ? 0 : entry.getPlayouts();
+        if (playouts < victimPlayouts) {
+            victim = &entry;
+            victimKey = key;
+            victimPlayouts = playouts;
+        }
+    }
+
+    if (victim->key.compare_exchange_strong(victimKey, hash, std::memory_order_acq_rel)) {
+        victim->playouts.store(0, std::memory_order_relaxed);
+        victim->score.store(0.f, std::memory_order_relaxed);
+        return victim;
+    }
+
+    return victimKey == hash ? victim : nullptr;
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i <= _bucketsMask; ++i) {
+        for (auto& entry : _buckets[i].entries) {
+            entry.key.store(0, std::memory_order_relaxed);
+            entry.playouts.store(0, std::memory_order_relaxed);
+            entry.score.store(0.f, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Fixed size table of node statistics shared by every move order that reaches the same
+// position, keyed by the Zobrist hash of the position after the move. Four entries share
+// a cache line; a full bucket gives up its least visited entry. Lookups and updates are
+// lock-free, racing writers may lose an update now and then, which the search tolerates.
+class TranspositionTable
+{
+public:
+    struct Entry {
+        std::atomic<uint64_t> key = {0};
+        std::atomic<unsigned> playouts = {0};
+        std::atomic<float> score = {0.f};
+
+        unsigned getPlayouts() const { return playouts.load(std::memory_order_relaxed); }
+        float getScore() const { return score.load(std::memory_order_relaxed); }
+        void add(float value) {
+            float current = score.load(std::memory_order_relaxed);
+            while (!score.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {}
+            playouts.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    // entriesCount is rounded down to a power of two
+    explicit TranspositionTable(size_t entriesCount);
+
+    // nullptr when the position isn't stored
+    const Entry* find(uint64_t hash) const;
+    // nullptr when another thread took the entry over in the meantime
+    Entry* findOrReplace(uint64_t hash);
+    void clear();
+
+    size_t getEntriesCount() const { return (_bucketsMask + 1) * BUCKET_SIZE; }
+private:
+    static constexpr size_t BUCKET_SIZE = 4;
+
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    std::unique_ptr<Bucket[]> _buckets;
+    size_t _bucketsMask = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "common.h"
+#include <algorithm>
+
+// Lines of one direction for boards too wide to pack a line of both players into one word:
+// every player has WORDS words per line, bit MARGIN + i is cell i of the line.
+// The empty margin in front of the line and the spare last word let any window that starts
+// up to MARGIN cells before the line be read from two neighbouring words without a branch.
+template<short SIZE, size_t LINES_COUNT>
+class WideLines
+{
+public:
+    static constexpr short MARGIN = 16;
+    static constexpr short WORD_BITS = 64;
+    static constexpr short WORDS = (MARGIN + SIZE + WORD_BITS - 1) / WORD_BITS + 1;
+
+    void clear() {
+        for (auto& line : _lines) {
+            line[0].fill(0);
+            line[1].fill(0);
+        }
+    }
+
+    void set(unsigned line, short cell, short color) { getWord(line, cell, color) |= getCellBit(cell); }
+    void reset(unsigned line, short cell, short color) { getWord(line, cell, color) &= ~getCellBit(cell); }
+
+    bool hasStone(unsigned line, short cell, short color) const {
+        return _lines[line][color - 1][getWordIndex(cell)] & getCellBit(cell);
+    }
+    bool isEmpty(unsigned line, short cell) const {
+        return !hasStone(line, cell, BLACK_PIECE_COLOR) && !hasStone(line, cell, WHITE_PIECE_COLOR);
+    }
+
+    // five or more stones in a row through cell, only the cells that can make such a row are read
+    bool hasRowOfFive(unsigned line, short cell, short color) const {
+        constexpr short REACH = MOVES_IN_ROW_TO_WIN - 1;
+        static_assert(REACH <= MARGIN, "the row has to start inside the margin");
+        uint64_t row = readBits(_lines[line][color - 1], MARGIN + cell - REACH) & ((1ull << (REACH * 2 + 1)) - 1);
+        for (short i = 1; i < MOVES_IN_ROW_TO_WIN; ++i) {
+            row &= row >> 1;
+        }
+
+        return row != 0;
+    }
+
+    // same layout as PackedLines::getWindow: black in the low CELLS bits and white above them,
+    // cells before the start of the line are set for both players
+    template<short BEFORE, short AFTER>
+    uint64_t getWindow(unsigned line, short cell) const {
+        constexpr short CELLS = BEFORE + AFTER + 1;
+        static_assert(BEFORE <= MARGIN && CELLS * 2 <= WORD_BITS, "the window has to fit a word");
+        constexpr uint64_t CELLS_MASK = (1ull << CELLS) - 1;
+
+        short start = MARGIN + cell - BEFORE;
+        uint64_t black = readBits(_lines[line][0], start) & CELLS_MASK;
+        uint64_t white = readBits(_lines[line][1], start) & CELLS_MASK;
+        uint64_t outside = ((1ull << BEFORE) - 1) >> std::min(cell, BEFORE);
+
+        return black | outside | ((white | outside) << CELLS);
+    }
+private:
+    using Line = std::array<uint64_t, WORDS>;
+
+    // 64 bits starting at bit, they may span two words
+    static uint64_t readBits(const Line& words, short bit) {
+        short word = bit / WORD_BITS;
+        short shift = bit % WORD_BITS;
+        return (words[word] >> shift) | ((words[word + 1] << 1) << (WORD_BITS - 1 - shift));
+    }
+
+    uint64_t& getWord(unsigned line, short cell, short color) { return _lines[line][color - 1][getWordIndex(cell)]; }
+    static short getWordIndex(short cell) { return (MARGIN + cell) / WORD_BITS; }
+    static uint64_t getCellBit(short cell) { return 1ull << ((MARGIN + cell) % WORD_BITS); }
+private:
+    std::array<std::array<Line, 2>, LINES_COUNT> _lines = {{}};
+};